@@ -51,11 +51,7 @@
 LSM6DSOXSensor::LSM6DSOXSensor(TwoWire *i2c, uint8_t address) : dev_i2c(i2c), address(address)
 {
   dev_spi = NULL;
-  reg_ctx.write_reg = LSM6DSOX_io_write;
-  reg_ctx.read_reg = LSM6DSOX_io_read;
-  reg_ctx.handle = (void *)this;
-  acc_is_enabled = 0U;
-  gyro_is_enabled = 0U;
+  Init(LSM6DSOX_io_write, LSM6DSOX_io_read);
 }
 
 /** Constructor
@@ -65,13 +61,38 @@ LSM6DSOXSensor::LSM6DSOXSensor(TwoWire *i2c, uint8_t address) : dev_i2c(i2c), ad
  */
 LSM6DSOXSensor::LSM6DSOXSensor(SPIClass *spi, int cs_pin, uint32_t spi_speed) : dev_spi(spi), cs_pin(cs_pin), spi_speed(spi_speed)
 {
-  reg_ctx.write_reg = LSM6DSOX_io_write;
-  reg_ctx.read_reg = LSM6DSOX_io_read;
-  reg_ctx.handle = (void *)this;
   dev_i2c = NULL;
   address = 0; 
+  Init(LSM6DSOX_io_write, LSM6DSOX_io_read);
+}
+
+/** Constructor for bus policy sensors (LSM6DSOXSensorT)
+ * @param write_reg register write callback handed to the register driver
+ * @param read_reg register read callback handed to the register driver
+ */
+LSM6DSOXSensor::LSM6DSOXSensor(lsm6dsox_write_ptr write_reg, lsm6dsox_read_ptr read_reg) : dev_i2c(NULL), dev_spi(NULL), address(0), cs_pin(-1), spi_speed(0)
+{
+  Init(write_reg, read_reg);
+}
+
+/**
+ * @brief  Common constructor setup
+ * @param  write_reg register write callback handed to the register driver
+ * @param  read_reg register read callback handed to the register driver
+ */
+void LSM6DSOXSensor::Init(lsm6dsox_write_ptr write_reg, lsm6dsox_read_ptr read_reg)
+{
+  reg_ctx.write_reg = write_reg;
+  reg_ctx.read_reg = read_reg;
+  reg_ctx.handle = (void *)this;
   acc_is_enabled = 0U;
-  gyro_is_enabled = 0U;  
+  gyro_is_enabled = 0U;
+  shadow_valid = 0U;
+  shadow_bank = 0U;
+  shadow_if_inc = 1U;
+  shadow_saved = 0U;
+  shadow_missed = 0U;
+  Reset_FIFO_Decompressor();
 }
 
 /**
@@ -87,6 +108,15 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::begin()
     digitalWrite(cs_pin, HIGH); 
   }
 
+  /* Nothing is known about the register contents until they are read back */
+  Invalidate_Shadow();
+
+  /* Bulk reads use DMA when built with LSM6DSOX_I2C_DMA */
+  if (dev_i2c)
+  {
+    i2cDmaBegin(dev_i2c);
+  }
+
   /* Disable I3C */
   if (lsm6dsox_i3c_disable_set(&reg_ctx, LSM6DSOX_I3C_DISABLE) != LSM6DSOX_OK)
   {
@@ -148,6 +178,61 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::begin()
   return LSM6DSOX_OK;
 }
 
+/**
+ * @brief  Attach to a sensor that kept its configuration across an MCU reset
+ * @note   Unlike begin() nothing is reset: the driver reads back which sensors
+ *         run and at what ODR. Only the register bank and auto-increment are forced,
+ *         since a reset in the middle of a UCF load can leave them changed.
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Resume()
+{
+  if(dev_spi)
+  {
+    // Configure CS pin
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH); 
+  }
+
+  Invalidate_Shadow();
+
+  if (dev_i2c)
+  {
+    i2cDmaBegin(dev_i2c);
+  }
+
+  if (lsm6dsox_mem_bank_set(&reg_ctx, LSM6DSOX_USER_BANK) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_auto_increment_set(&reg_ctx, PROPERTY_ENABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  lsm6dsox_odr_xl_t odr_xl;
+  lsm6dsox_odr_g_t odr_g;
+
+  if (lsm6dsox_xl_data_rate_get(&reg_ctx, &odr_xl) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_gy_data_rate_get(&reg_ctx, &odr_g) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* Powered-down sensors keep the begin() defaults for the next Enable_X/G */
+  acc_is_enabled = (odr_xl != LSM6DSOX_XL_ODR_OFF) ? 1U : 0U;
+  acc_odr = acc_is_enabled ? odr_xl : LSM6DSOX_XL_ODR_104Hz;
+  gyro_is_enabled = (odr_g != LSM6DSOX_GY_ODR_OFF) ? 1U : 0U;
+  gyro_odr = gyro_is_enabled ? odr_g : LSM6DSOX_GY_ODR_104Hz;
+
+  return LSM6DSOX_OK;
+}
+
 /**
  * @brief  Disable the sensor and relative resources
  * @retval 0 in case of success, an error code otherwise
@@ -1198,6 +1283,46 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Write_Reg(uint8_t Reg, uint8_t Data)
     return LSM6DSOX_ERROR;
   }
 
+  /* Raw writes (e.g. UCF programs) may reconfigure the sensor behind the driver */
+  Invalidate_Shadow();
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Write several bytes in one bus transaction starting at a register
+ * @param  Reg first register to be written
+ * @param  Data values to be written
+ * @param  Len number of bytes
+ * @note   With IF_INC cleared in CTRL3_C every byte goes to Reg, e.g. PAGE_VALUE runs
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Write_Reg_Burst(uint8_t Reg, const uint8_t *Data, uint16_t Len)
+{
+  if (lsm6dsox_write_reg(&reg_ctx, Reg, (uint8_t *)Data, Len) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  Invalidate_Shadow();
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Read several bytes in one bus transaction starting at a register
+ * @param  Reg first register to be read
+ * @param  Data buffer for the values read
+ * @param  Len number of bytes
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Read_Reg_Burst(uint8_t Reg, uint8_t *Data, uint16_t Len)
+{
+  if (lsm6dsox_read_reg(&reg_ctx, Reg, Data, Len) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
   return LSM6DSOX_OK;
 }
 
@@ -2641,6 +2766,23 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_X_Event_Status(LSM6DSOX_Event_Status_t
   return LSM6DSOX_OK;
 }
 
+/**
+ * @brief  Get every interrupt source in one burst (ALL_INT_SRC up to FIFO_STATUS2)
+ * @param  Sources the decoded sources
+ * @note   The CTRL5_C rounding setup this needs is written once; the shadow cache
+ *         skips it afterwards, so each call is a single bus transaction.
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_All_Sources(lsm6dsox_all_sources_t *Sources)
+{
+  if (lsm6dsox_all_sources_get(&reg_ctx, Sources) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
 /**
  * @brief  Set self test
  * @param  val the value of st_xl in reg CTRL5_C
@@ -3187,28 +3329,102 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_MLC_Output(uint8_t *Output)
 }
 
 /**
- * @brief  Get the LSM6DSOX timestamp enable status
- * @param  Status Timestamp enable status
+ * @brief  Load Finite State Machine programs into the advanced embedded pages
+ * @param  Programs the programs back to back, as generated by the FSM tools
+ * @param  Len total size of Programs in bytes
+ * @param  Count number of programs (1 to LSM6DSOX_FSM_MAX_PROGRAMS)
+ * @param  StartAddress first page address, as given by a combined MLC/FSM export
+ * @note   The FSMs are disabled while loading; call Enable_FSM() afterwards.
+ *         Nothing here checks the range against MLC pages already loaded.
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Timestamp_Status(uint8_t *Status)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Load_FSM_Programs(const uint8_t *Programs, uint16_t Len, uint8_t Count, uint16_t StartAddress)
 {
-  if (lsm6dsox_timestamp_get(&reg_ctx, Status) != LSM6DSOX_OK)
+  if (Count == 0U || Count > LSM6DSOX_FSM_MAX_PROGRAMS || (uint32_t)StartAddress + Len > 0xFFFFU)
   {
     return LSM6DSOX_ERROR;
   }
 
+  if (Disable_FSM() != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_fsm_number_of_programs_set(&reg_ctx, Count) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_fsm_start_address_set(&reg_ctx, StartAddress) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* lsm6dsox_ln_pg_write() takes at most 255 bytes per call */
+  uint16_t offset = 0;
+  while (offset < Len)
+  {
+    uint16_t chunk = Len - offset;
+    if (chunk > 255U)
+    {
+      chunk = 255U;
+    }
+
+    if (lsm6dsox_ln_pg_write(&reg_ctx, StartAddress + offset, (uint8_t *)&Programs[offset], (uint8_t)chunk) != LSM6DSOX_OK)
+    {
+      return LSM6DSOX_ERROR;
+    }
+    offset += chunk;
+  }
+
   return LSM6DSOX_OK;
 }
 
 /**
- * @brief  Set the LSM6DSOX timestamp enable status
- * @param  Status Timestamp enable status
+ * @brief  Enable Finite State Machine programs
+ * @param  Mask bit n enables program n+1
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_Timestamp_Status(uint8_t Status)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Enable_FSM(uint16_t Mask)
 {
-  if (lsm6dsox_timestamp_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  lsm6dsox_emb_fsm_enable_t enable;
+  lsm6dsox_emb_func_en_b_t emb_func_en_b;
+
+  uint8_t mask_a = (uint8_t)(Mask & 0xFFU);
+  uint8_t mask_b = (uint8_t)(Mask >> 8);
+
+  memcpy(&enable.fsm_enable_a, &mask_a, 1);
+  memcpy(&enable.fsm_enable_b, &mask_b, 1);
+
+  if (lsm6dsox_fsm_enable_set(&reg_ctx, &enable) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_mem_bank_set(&reg_ctx, LSM6DSOX_EMBEDDED_FUNC_BANK) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_read_reg(&reg_ctx, LSM6DSOX_EMB_FUNC_EN_B, (uint8_t *)&emb_func_en_b, 1) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  emb_func_en_b.fsm_en = (Mask != 0U) ? 1U : 0U;
+
+  if (lsm6dsox_write_reg(&reg_ctx, LSM6DSOX_EMB_FUNC_EN_B, (uint8_t *)&emb_func_en_b, 1) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_mem_bank_set(&reg_ctx, LSM6DSOX_USER_BANK) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* Start every enabled program from its reset state */
+  if (Mask != 0U && lsm6dsox_fsm_init_set(&reg_ctx, PROPERTY_ENABLE) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
@@ -3217,49 +3433,77 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_Timestamp_Status(uint8_t Status)
 }
 
 /**
- * @brief  Set the LSM6DSOX FIFO timestamp decimation
- * @param  Decimation FIFO timestamp decimation
+ * @brief  Disable all Finite State Machine programs
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Timestamp_Decimation(uint8_t Decimation)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Disable_FSM()
 {
-  LSM6DSOXStatusTypeDef ret = LSM6DSOX_OK;
+  return Enable_FSM(0U);
+}
 
-  /* Verify that the passed parameter contains one of the valid values. */
-  switch ((lsm6dsox_odr_ts_batch_t)Decimation)
-  {
-    case LSM6DSOX_NO_DECIMATION:
-    case LSM6DSOX_DEC_1:
-    case LSM6DSOX_DEC_8:
-    case LSM6DSOX_DEC_32:
-      break;
+/**
+ * @brief  Set the Finite State Machine output data rate
+ * @param  Odr the output data rate value (12.5, 26, 52 or 104 Hz)
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FSM_ODR(float Odr)
+{
+  lsm6dsox_fsm_odr_t new_odr;
 
-    default:
-      ret = LSM6DSOX_ERROR;
-      break;
+  new_odr = (Odr <= 12.5f) ? LSM6DSOX_ODR_FSM_12Hz5
+          : (Odr <= 26.0f) ? LSM6DSOX_ODR_FSM_26Hz
+          : (Odr <= 52.0f) ? LSM6DSOX_ODR_FSM_52Hz
+          :                  LSM6DSOX_ODR_FSM_104Hz;
+
+  if (lsm6dsox_fsm_data_rate_set(&reg_ctx, new_odr) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
   }
 
-  if (ret == LSM6DSOX_ERROR)
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Set the long counter value that raises the FSM long counter interrupt
+ * @param  Timeout long counter timeout (16 bit)
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FSM_Long_Counter_Timeout(uint16_t Timeout)
+{
+  if (lsm6dsox_long_cnt_int_value_set(&reg_ctx, Timeout) != LSM6DSOX_OK)
   {
-    return ret;
+    return LSM6DSOX_ERROR;
   }
 
-  if (lsm6dsox_fifo_timestamp_decimation_set(&reg_ctx, (lsm6dsox_odr_ts_batch_t)Decimation) != LSM6DSOX_OK)
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get the FSM long counter
+ * @param  Count the long counter value
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_FSM_Long_Counter(uint16_t *Count)
+{
+  uint8_t buff[2];
+
+  if (lsm6dsox_long_cnt_get(&reg_ctx, buff) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
 
-  return ret;
+  *Count = (uint16_t)buff[0] | ((uint16_t)buff[1] << 8);
+
+  return LSM6DSOX_OK;
 }
 
 /**
- * @brief  Set the LSM6DSOX FIFO compression initialization status
- * @param  Status FIFO compression initialization status
+ * @brief  Reset the FSM long counter
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Init(uint8_t Status)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Reset_FSM_Long_Counter()
 {
-  if (lsm6dsox_compression_algo_init_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  if (lsm6dsox_long_clr_set(&reg_ctx, LSM6DSOX_LC_CLEAR) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
@@ -3268,21 +3512,32 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Init(uint8_t Sta
 }
 
 /**
- * @brief  Set the LSM6DSOX FIFO compression enable status
- * @param  Status FIFO compression enable status
+ * @brief  Get which FSM programs raised an interrupt (FSM_STATUS_A/B_MAINPAGE)
+ * @param  Status bit n set when program n+1 signalled
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Enable(uint8_t Status)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_FSM_Status(uint16_t *Status)
 {
-  lsm6dsox_emb_sens_t val;
-  if (lsm6dsox_embedded_sens_get(&reg_ctx, &val) != LSM6DSOX_OK)
+  uint8_t buff[2];
+
+  if (lsm6dsox_read_reg(&reg_ctx, LSM6DSOX_FSM_STATUS_A_MAINPAGE, buff, 2) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
 
-  val.fifo_compr = Status;
+  *Status = (uint16_t)buff[0] | ((uint16_t)buff[1] << 8);
 
-  if (lsm6dsox_embedded_sens_set(&reg_ctx, &val) != LSM6DSOX_OK)
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get the FSM program outputs (FSM_OUTS1..FSM_OUTS16)
+ * @param  Output buffer of LSM6DSOX_FSM_MAX_PROGRAMS bytes
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_FSM_Output(uint8_t *Output)
+{
+  if (lsm6dsox_fsm_out_get(&reg_ctx, (lsm6dsox_fsm_out_t *)Output) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
@@ -3291,64 +3546,1031 @@ LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Enable(uint8_t S
 }
 
 /**
- * @brief  Set the LSM6DSOX FIFO compression configuration and enable status
- * @param  Compression FIFO compression and enable status
+ * @brief  Route FSM program interrupts to an interrupt pin
+ * @param  IntPin interrupt pin
+ * @param  Mask bit n routes program n+1; 0 removes the FSM routing from the pin
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Set(uint8_t Compression)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FSM_Interrupt(LSM6DSOX_SensorIntPin_t IntPin, uint16_t Mask)
 {
-  LSM6DSOXStatusTypeDef ret = LSM6DSOX_OK;
+  uint8_t route[2] = { (uint8_t)(Mask & 0xFFU), (uint8_t)(Mask >> 8) };
+  uint8_t route_reg = (IntPin == LSM6DSOX_INT1_PIN) ? LSM6DSOX_FSM_INT1_A : LSM6DSOX_FSM_INT2_A;
 
-  /* Verify that the passed parameter contains one of the valid values. */
-  switch ((lsm6dsox_uncoptr_rate_t)Compression)
+  if (lsm6dsox_mem_bank_set(&reg_ctx, LSM6DSOX_EMBEDDED_FUNC_BANK) != LSM6DSOX_OK)
   {
-    case LSM6DSOX_CMP_DISABLE:
-    case LSM6DSOX_CMP_ALWAYS:
-    case LSM6DSOX_CMP_8_TO_1:
-    case LSM6DSOX_CMP_16_TO_1:
-    case LSM6DSOX_CMP_32_TO_1:
-      break;
+    return LSM6DSOX_ERROR;
+  }
 
-    default:
-      ret = LSM6DSOX_ERROR;
-      break;
+  if (lsm6dsox_write_reg(&reg_ctx, route_reg, route, 2) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
   }
 
+  if (lsm6dsox_mem_bank_set(&reg_ctx, LSM6DSOX_USER_BANK) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
 
-  if (ret == LSM6DSOX_ERROR)
+  /* Embedded function interrupts reach the pin through MD1_CFG/MD2_CFG; the MLC
+     shares that bit, so it is only ever set here */
+  if (Mask == 0U)
   {
-    return ret;
+    return LSM6DSOX_OK;
   }
 
-  if (lsm6dsox_compression_algo_set(&reg_ctx, (lsm6dsox_uncoptr_rate_t)Compression) != LSM6DSOX_OK)
+  uint8_t md_reg = (IntPin == LSM6DSOX_INT1_PIN) ? LSM6DSOX_MD1_CFG : LSM6DSOX_MD2_CFG;
+  uint8_t md_cfg;
+
+  if (lsm6dsox_read_reg(&reg_ctx, md_reg, &md_cfg, 1) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
 
-  return ret;
+  md_cfg |= 0x02U;
+
+  if (lsm6dsox_write_reg(&reg_ctx, md_reg, &md_cfg, 1) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
 }
 
 /**
- * @brief  Set the LSM6DSOX FIFO compression real time enable status
- * @param  Status FIFO compression real time enable status
+ * @brief  Write one register of an external sensor through the sensor hub
+ * @param  Address 7-bit I2C address of the external sensor
+ * @param  Reg register of the external sensor
+ * @param  Value value to be written
+ * @note   The write goes out on slave 0 during one sensor hub cycle triggered by
+ *         the accelerometer, which runs at 104 Hz for the duration if it is off.
+ *         Slave 0 is left pointing at the written register, so configure its
+ *         read with Sensor_Hub_Config_Slave() after the last write.
  * @retval 0 in case of success, an error code otherwise
  */
-LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Real_Time_Set(uint8_t Status)
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Sensor_Hub_Write(uint8_t Address, uint8_t Reg, uint8_t Value)
 {
-  if (lsm6dsox_compression_algo_real_time_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  lsm6dsox_sh_cfg_write_t cfg;
+  lsm6dsox_status_master_t status;
+  lsm6dsox_odr_xl_t xl_odr;
+  float odr;
+  LSM6DSOXStatusTypeDef ret = LSM6DSOX_OK;
+
+  cfg.slv0_add = Address;
+  cfg.slv0_subadd = Reg;
+  cfg.slv0_data = Value;
+
+  if (lsm6dsox_sh_master_set(&reg_ctx, PROPERTY_DISABLE) != LSM6DSOX_OK)
   {
     return LSM6DSOX_ERROR;
   }
 
-  return LSM6DSOX_OK;
+  if (lsm6dsox_sh_cfg_write(&reg_ctx, &cfg) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_write_mode_set(&reg_ctx, LSM6DSOX_ONLY_FIRST_CYCLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_syncro_mode_set(&reg_ctx, LSM6DSOX_XL_GY_DRDY) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_slave_connected_set(&reg_ctx, LSM6DSOX_SLV_0) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* The sensor hub cycle is triggered by the accelerometer data-ready */
+  if (lsm6dsox_xl_data_rate_get(&reg_ctx, &xl_odr) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (xl_odr == LSM6DSOX_XL_ODR_OFF && lsm6dsox_xl_data_rate_set(&reg_ctx, LSM6DSOX_XL_ODR_104Hz) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* The write goes out on the first trigger; allow two periods of the running rate */
+  if (Get_X_ODR(&odr) != LSM6DSOX_OK || odr <= 0.0f)
+  {
+    return LSM6DSOX_ERROR;
+  }
+  uint32_t timeout = (uint32_t)(2000.0f / odr) + LSM6DSOX_SH_WRITE_MARGIN;
+
+  if (lsm6dsox_sh_master_set(&reg_ctx, PROPERTY_ENABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  uint32_t start = millis();
+  do
+  {
+    if (lsm6dsox_sh_status_get(&reg_ctx, &status) != LSM6DSOX_OK)
+    {
+      ret = LSM6DSOX_ERROR;
+      break;
+    }
+    if (millis() - start > timeout)
+    {
+      ret = LSM6DSOX_ERROR;
+      break;
+    }
+  } while (status.wr_once_done == 0U);
+
+  if (ret == LSM6DSOX_OK && status.slave0_nack != 0U)
+  {
+    ret = LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_master_set(&reg_ctx, PROPERTY_DISABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (xl_odr == LSM6DSOX_XL_ODR_OFF && lsm6dsox_xl_data_rate_set(&reg_ctx, LSM6DSOX_XL_ODR_OFF) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return ret;
+}
+
+/**
+ * @brief  Set the register block the sensor hub reads from an external sensor
+ * @param  Slave sensor hub slave, 0 to 3; slaves fill SENSOR_HUB_x in order
+ * @param  Address 7-bit I2C address of the external sensor
+ * @param  Reg first register to read
+ * @param  Len number of bytes to read, 1 to 7
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Sensor_Hub_Config_Slave(uint8_t Slave, uint8_t Address, uint8_t Reg, uint8_t Len)
+{
+  lsm6dsox_sh_cfg_read_t cfg;
+  int32_t ret;
+
+  if (Len == 0U || Len > 7U)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  cfg.slv_add = Address;
+  cfg.slv_subadd = Reg;
+  cfg.slv_len = Len;
+
+  switch (Slave)
+  {
+    case 0:
+      ret = lsm6dsox_sh_slv0_cfg_read(&reg_ctx, &cfg);
+      break;
+    case 1:
+      ret = lsm6dsox_sh_slv1_cfg_read(&reg_ctx, &cfg);
+      break;
+    case 2:
+      ret = lsm6dsox_sh_slv2_cfg_read(&reg_ctx, &cfg);
+      break;
+    case 3:
+      ret = lsm6dsox_sh_slv3_cfg_read(&reg_ctx, &cfg);
+      break;
+    default:
+      return LSM6DSOX_ERROR;
+  }
+
+  if (ret != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Start the sensor hub reading the configured slaves
+ * @param  Slaves number of slaves to read, 1 to 4, starting from slave 0
+ * @param  Odr sensor hub rate in Hz, capped by the accelerometer/gyro rate that triggers it
+ * @param  InternalPullUp 1 to use the internal pull-ups on the master I2C lines
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Sensor_Hub_Enable(uint8_t Slaves, float Odr, uint8_t InternalPullUp)
+{
+  lsm6dsox_shub_odr_t new_odr;
+
+  if (Slaves == 0U || Slaves > LSM6DSOX_SH_MAX_SLAVES)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  new_odr = (Odr <= 13.0f) ? LSM6DSOX_SH_ODR_13Hz
+          : (Odr <= 26.0f) ? LSM6DSOX_SH_ODR_26Hz
+          : (Odr <= 52.0f) ? LSM6DSOX_SH_ODR_52Hz
+          :                  LSM6DSOX_SH_ODR_104Hz;
+
+  if (lsm6dsox_sh_pin_mode_set(&reg_ctx, (InternalPullUp != 0U) ? LSM6DSOX_INTERNAL_PULL_UP : LSM6DSOX_EXT_PULL_UP) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_data_rate_set(&reg_ctx, new_odr) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_syncro_mode_set(&reg_ctx, LSM6DSOX_XL_GY_DRDY) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_slave_connected_set(&reg_ctx, (lsm6dsox_aux_sens_on_t)(Slaves - 1U)) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_master_set(&reg_ctx, PROPERTY_ENABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Stop the sensor hub
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Sensor_Hub_Disable()
+{
+  if (lsm6dsox_sh_master_set(&reg_ctx, PROPERTY_DISABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Read the latest external sensor bytes collected by the sensor hub
+ * @param  Data buffer for the SENSOR_HUB_x bytes, slave 0 first
+ * @param  Len number of bytes to read, at most LSM6DSOX_SH_MAX_BYTES
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Sensor_Hub_Data(uint8_t *Data, uint8_t Len)
+{
+  if (Len > LSM6DSOX_SH_MAX_BYTES)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (lsm6dsox_sh_read_data_raw_get(&reg_ctx, (lsm6dsox_emb_sh_read_t *)Data, Len) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get which slaves did not acknowledge during the last sensor hub cycle
+ * @param  Nack bit i set if slave i did not acknowledge
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Sensor_Hub_Nack(uint8_t *Nack)
+{
+  lsm6dsox_status_master_t status;
+
+  if (lsm6dsox_sh_status_get(&reg_ctx, &status) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  *Nack = (uint8_t)(status.slave0_nack | (status.slave1_nack << 1) | (status.slave2_nack << 2) | (status.slave3_nack << 3));
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Enable or disable batching of a sensor hub slave in the FIFO
+ * @param  Slave sensor hub slave, 0 to 3
+ * @param  Status 1 to batch the slave readings, 0 otherwise
+ * @note   Slave words share the FIFO time slots with accelerometer/gyro words,
+ *         so Decode_FIFO_Word() stamps them from the same timestamp words
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Sensor_Hub_Batch(uint8_t Slave, uint8_t Status)
+{
+  int32_t ret;
+
+  switch (Slave)
+  {
+    case 0:
+      ret = lsm6dsox_sh_batch_slave_0_set(&reg_ctx, Status);
+      break;
+    case 1:
+      ret = lsm6dsox_sh_batch_slave_1_set(&reg_ctx, Status);
+      break;
+    case 2:
+      ret = lsm6dsox_sh_batch_slave_2_set(&reg_ctx, Status);
+      break;
+    case 3:
+      ret = lsm6dsox_sh_batch_slave_3_set(&reg_ctx, Status);
+      break;
+    default:
+      return LSM6DSOX_ERROR;
+  }
+
+  if (ret != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get the LSM6DSOX timestamp enable status
+ * @param  Status Timestamp enable status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Timestamp_Status(uint8_t *Status)
+{
+  if (lsm6dsox_timestamp_get(&reg_ctx, Status) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Set the LSM6DSOX timestamp enable status
+ * @param  Status Timestamp enable status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_Timestamp_Status(uint8_t Status)
+{
+  if (lsm6dsox_timestamp_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get the LSM6DSOX timestamp resolution, trimmed by INTERNAL_FREQ_FINE
+ * @param  Resolution duration of one timestamp tick in microseconds
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Timestamp_Resolution(float *Resolution)
+{
+  uint8_t freq_fine;
+
+  if (lsm6dsox_odr_cal_reg_get(&reg_ctx, &freq_fine) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* Nominal 25 us tick, corrected by 0.15% per LSB of the signed trim */
+  *Resolution = 25.0f / (1.0f + 0.0015f * (float)(int8_t)freq_fine);
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Set the LSM6DSOX FIFO timestamp decimation
+ * @param  Decimation FIFO timestamp decimation
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Timestamp_Decimation(uint8_t Decimation)
+{
+  LSM6DSOXStatusTypeDef ret = LSM6DSOX_OK;
+
+  /* Verify that the passed parameter contains one of the valid values. */
+  switch ((lsm6dsox_odr_ts_batch_t)Decimation)
+  {
+    case LSM6DSOX_NO_DECIMATION:
+    case LSM6DSOX_DEC_1:
+    case LSM6DSOX_DEC_8:
+    case LSM6DSOX_DEC_32:
+      break;
+
+    default:
+      ret = LSM6DSOX_ERROR;
+      break;
+  }
+
+  if (ret == LSM6DSOX_ERROR)
+  {
+    return ret;
+  }
+
+  if (lsm6dsox_fifo_timestamp_decimation_set(&reg_ctx, (lsm6dsox_odr_ts_batch_t)Decimation) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return ret;
+}
+
+/**
+ * @brief  Set the LSM6DSOX FIFO compression initialization status
+ * @param  Status FIFO compression initialization status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Init(uint8_t Status)
+{
+  if (lsm6dsox_compression_algo_init_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Set the LSM6DSOX FIFO compression enable status
+ * @param  Status FIFO compression enable status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Enable(uint8_t Status)
+{
+  lsm6dsox_emb_sens_t val;
+  if (lsm6dsox_embedded_sens_get(&reg_ctx, &val) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  val.fifo_compr = Status;
+
+  if (lsm6dsox_embedded_sens_set(&reg_ctx, &val) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Set the LSM6DSOX FIFO compression configuration and enable status
+ * @param  Compression FIFO compression and enable status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Set(uint8_t Compression)
+{
+  LSM6DSOXStatusTypeDef ret = LSM6DSOX_OK;
+
+  /* Verify that the passed parameter contains one of the valid values. */
+  switch ((lsm6dsox_uncoptr_rate_t)Compression)
+  {
+    case LSM6DSOX_CMP_DISABLE:
+    case LSM6DSOX_CMP_ALWAYS:
+    case LSM6DSOX_CMP_8_TO_1:
+    case LSM6DSOX_CMP_16_TO_1:
+    case LSM6DSOX_CMP_32_TO_1:
+      break;
+
+    default:
+      ret = LSM6DSOX_ERROR;
+      break;
+  }
+
+
+  if (ret == LSM6DSOX_ERROR)
+  {
+    return ret;
+  }
+
+  if (lsm6dsox_compression_algo_set(&reg_ctx, (lsm6dsox_uncoptr_rate_t)Compression) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return ret;
+}
+
+/**
+ * @brief  Set the LSM6DSOX FIFO compression real time enable status
+ * @param  Status FIFO compression real time enable status
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Set_FIFO_Compression_Algo_Real_Time_Set(uint8_t Status)
+{
+  if (lsm6dsox_compression_algo_real_time_set(&reg_ctx, Status) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Enable the LSM6DSOX FIFO compression
+ * @param  Compression one of LSM6DSOX_CMP_ALWAYS, LSM6DSOX_CMP_8_TO_1,
+ *         LSM6DSOX_CMP_16_TO_1 or LSM6DSOX_CMP_32_TO_1
+ * @note   Words read afterwards must go through Decode_FIFO_Word()
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Enable_FIFO_Compression(uint8_t Compression)
+{
+  if (Compression == LSM6DSOX_CMP_DISABLE)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (Set_FIFO_Compression_Algo_Enable(1) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (Set_FIFO_Compression_Algo_Set(Compression) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  /* Restart the algorithm so the stream begins with an uncompressed word */
+  if (Set_FIFO_Compression_Algo_Init(1) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  Reset_FIFO_Decompressor();
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Disable the LSM6DSOX FIFO compression
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Disable_FIFO_Compression()
+{
+  if (Set_FIFO_Compression_Algo_Set(LSM6DSOX_CMP_DISABLE) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  if (Set_FIFO_Compression_Algo_Enable(0) != LSM6DSOX_OK)
+  {
+    return LSM6DSOX_ERROR;
+  }
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Forget the reference samples used to rebuild compressed FIFO words
+ */
+void LSM6DSOXSensor::Reset_FIFO_Decompressor()
+{
+  fifo_last_valid[0] = 0U;
+  fifo_last_valid[1] = 0U;
+  fifo_ts_count = 0U;
+}
+
+/**
+ * @brief  Decode one FIFO word, rebuilding compressed accelero/gyro samples
+ * @param  Word FIFO word as read by Get_FIFO_Sample() [7 bytes, tag first]
+ * @param  Decoded decoded word; Count is 0 for words that carry no XL/gyro/sensor hub samples
+ * @note   NC words hold a full sample, 2xC words two samples as 8-bit deltas and
+ *         3xC words three samples as 5-bit deltas. Deltas chain from the previous
+ *         sample of the same sensor, oldest first, so words must be decoded in
+ *         the order they were read. Timestamp words open each time slot and are
+ *         matched to the slots (t, t-1, t-2) the data words refer to.
+ * @retval 0 in case of success, an error code if a compressed word has no reference
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Decode_FIFO_Word(const uint8_t *Word, LSM6DSOX_FIFO_Decoded_t *Decoded)
+{
+  const uint8_t *data = &Word[1];
+  uint8_t stream;
+  uint8_t slot;
+
+  Decoded->Tag = Word[0] >> 3;
+  Decoded->Count = 0U;
+  Decoded->Timestamp_Valid = 0U;
+
+  if (Decoded->Tag == LSM6DSOX_TIMESTAMP_TAG)
+  {
+    fifo_ts[0] = fifo_ts[1];
+    fifo_ts[1] = fifo_ts[2];
+    fifo_ts[2] = ((uint32_t)data[3] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[1] << 8) | data[0];
+    if (fifo_ts_count < 3U)
+    {
+      fifo_ts_count++;
+    }
+    Decoded->Sensor = LSM6DSOX_FIFO_SENSOR_NONE;
+    return LSM6DSOX_OK;
+  }
+
+  switch (Decoded->Tag)
+  {
+    case LSM6DSOX_XL_NC_TAG:
+    case LSM6DSOX_XL_NC_T_1_TAG:
+    case LSM6DSOX_XL_NC_T_2_TAG:
+    case LSM6DSOX_XL_2XC_TAG:
+    case LSM6DSOX_XL_3XC_TAG:
+      Decoded->Sensor = LSM6DSOX_FIFO_SENSOR_XL;
+      stream = 0U;
+      break;
+
+    case LSM6DSOX_GYRO_NC_TAG:
+    case LSM6DSOX_GYRO_NC_T_1_TAG:
+    case LSM6DSOX_GYRO_NC_T_2_TAG:
+    case LSM6DSOX_GYRO_2XC_TAG:
+    case LSM6DSOX_GYRO_3XC_TAG:
+      Decoded->Sensor = LSM6DSOX_FIFO_SENSOR_GYRO;
+      stream = 1U;
+      break;
+
+    case LSM6DSOX_SENSORHUB_SLAVE0_TAG:
+    case LSM6DSOX_SENSORHUB_SLAVE1_TAG:
+    case LSM6DSOX_SENSORHUB_SLAVE2_TAG:
+    case LSM6DSOX_SENSORHUB_SLAVE3_TAG:
+      /* Sensor hub words are never compressed and belong to the current slot;
+         the slave bytes are handed back as read, packed little-endian */
+      Decoded->Sensor = LSM6DSOX_FIFO_SENSOR_EXT;
+      Decoded->Slave = Decoded->Tag - LSM6DSOX_SENSORHUB_SLAVE0_TAG;
+      for (uint8_t axis = 0; axis < 3U; axis++)
+      {
+        Decoded->Data[0][axis] = (int16_t)(((uint16_t)data[2U * axis + 1U] << 8) | data[2U * axis]);
+      }
+      Decoded->Count = 1U;
+      if (fifo_ts_count >= 1U)
+      {
+        Decoded->Timestamp[0] = fifo_ts[2];
+        Decoded->Timestamp_Valid = 1U;
+      }
+      return LSM6DSOX_OK;
+
+    default:
+      Decoded->Sensor = LSM6DSOX_FIFO_SENSOR_NONE;
+      return LSM6DSOX_OK;
+  }
+
+  switch (Decoded->Tag)
+  {
+    case LSM6DSOX_XL_NC_TAG:
+    case LSM6DSOX_XL_NC_T_1_TAG:
+    case LSM6DSOX_XL_NC_T_2_TAG:
+    case LSM6DSOX_GYRO_NC_TAG:
+    case LSM6DSOX_GYRO_NC_T_1_TAG:
+    case LSM6DSOX_GYRO_NC_T_2_TAG:
+      for (uint8_t axis = 0; axis < 3U; axis++)
+      {
+        Decoded->Data[0][axis] = (int16_t)(((uint16_t)data[2U * axis + 1U] << 8) | data[2U * axis]);
+      }
+      Decoded->Count = 1U;
+      if (Decoded->Tag == LSM6DSOX_XL_NC_TAG || Decoded->Tag == LSM6DSOX_GYRO_NC_TAG)
+      {
+        slot = 2U;
+      }
+      else if (Decoded->Tag == LSM6DSOX_XL_NC_T_1_TAG || Decoded->Tag == LSM6DSOX_GYRO_NC_T_1_TAG)
+      {
+        slot = 1U;
+      }
+      else
+      {
+        slot = 0U;
+      }
+      break;
+
+    case LSM6DSOX_XL_2XC_TAG:
+    case LSM6DSOX_GYRO_2XC_TAG:
+      if (fifo_last_valid[stream] == 0U)
+      {
+        return LSM6DSOX_ERROR;
+      }
+      for (uint8_t i = 0; i < 2U; i++)
+      {
+        const int16_t *prev = (i == 0U) ? fifo_last[stream] : Decoded->Data[i - 1U];
+
+        for (uint8_t axis = 0; axis < 3U; axis++)
+        {
+          Decoded->Data[i][axis] = (int16_t)(prev[axis] + (int8_t)data[3U * i + axis]);
+        }
+      }
+      Decoded->Count = 2U;
+      slot = 0U;
+      break;
+
+    default: /* 3xC */
+      if (fifo_last_valid[stream] == 0U)
+      {
+        return LSM6DSOX_ERROR;
+      }
+      for (uint8_t i = 0; i < 3U; i++)
+      {
+        const int16_t *prev = (i == 0U) ? fifo_last[stream] : Decoded->Data[i - 1U];
+        uint16_t packed = ((uint16_t)data[2U * i + 1U] << 8) | data[2U * i];
+
+        for (uint8_t axis = 0; axis < 3U; axis++)
+        {
+          int16_t diff = (int16_t)((packed >> (5U * axis)) & 0x1FU);
+
+          /* 5-bit two's complement */
+          if (diff >= 16)
+          {
+            diff -= 32;
+          }
+          Decoded->Data[i][axis] = (int16_t)(prev[axis] + diff);
+        }
+      }
+      Decoded->Count = 3U;
+      slot = 0U;
+      break;
+  }
+
+  /* Slot 2 is the newest timestamp, so only the last 3 - slot entries must be known */
+  if (fifo_ts_count >= 3U - slot)
+  {
+    for (uint8_t i = 0; i < Decoded->Count; i++)
+    {
+      Decoded->Timestamp[i] = fifo_ts[slot + i];
+    }
+    Decoded->Timestamp_Valid = 1U;
+  }
+
+  memcpy(fifo_last[stream], Decoded->Data[Decoded->Count - 1U], sizeof(fifo_last[stream]));
+  fifo_last_valid[stream] = 1U;
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Get the shadow register cache statistics
+ * @param  Saved number of bus transactions served from the cache
+ * @param  Missed number of cacheable reads that had to go to the bus
+ * @retval 0 in case of success, an error code otherwise
+ */
+LSM6DSOXStatusTypeDef LSM6DSOXSensor::Get_Shadow_Stats(uint32_t *Saved, uint32_t *Missed)
+{
+  *Saved = shadow_saved;
+  *Missed = shadow_missed;
+
+  return LSM6DSOX_OK;
+}
+
+/**
+ * @brief  Drop every shadowed register value so the next access reads the bus
+ */
+void LSM6DSOXSensor::Invalidate_Shadow()
+{
+  shadow_valid = 0U;
+}
+
+/**
+ * @brief  Compute which shadowed registers a user bank access touches
+ * @param  RegisterAddr first register address of the access
+ * @param  NumBytes number of bytes accessed
+ * @retval shadow mask of the touched registers, 0 if none
+ */
+uint16_t LSM6DSOXSensor::Shadow_Mask(uint8_t RegisterAddr, uint16_t NumBytes)
+{
+  uint16_t mask = 0U;
+
+  /* Embedded function and sensor hub banks alias the same addresses */
+  if (shadow_bank != 0U)
+  {
+    return 0U;
+  }
+
+  /* Fast exit for FIFO and output register bursts */
+  if (RegisterAddr >= LSM6DSOX_SHADOW_FIRST_REG + LSM6DSOX_SHADOW_NUM_REGS
+      || (uint16_t)RegisterAddr + NumBytes <= LSM6DSOX_SHADOW_FIRST_REG)
+  {
+    return 0U;
+  }
+
+  /* Without auto-increment a burst hits the same register repeatedly */
+  if (shadow_if_inc == 0U)
+  {
+    NumBytes = 1U;
+  }
+
+  for (uint16_t i = 0; i < NumBytes; i++)
+  {
+    uint16_t reg = (uint16_t)RegisterAddr + i;
+
+    if (reg >= LSM6DSOX_SHADOW_FIRST_REG && reg < LSM6DSOX_SHADOW_FIRST_REG + LSM6DSOX_SHADOW_NUM_REGS)
+    {
+      mask |= (uint16_t)(1U << (reg - LSM6DSOX_SHADOW_FIRST_REG));
+    }
+  }
+
+  return mask & LSM6DSOX_SHADOW_REG_MASK;
+}
+
+/**
+ * @brief  Record register values that were just read from or written to the bus
+ * @param  RegisterAddr first register address of the access
+ * @param  pBuffer register values
+ * @param  NumBytes number of bytes accessed
+ */
+void LSM6DSOXSensor::Shadow_Store(uint8_t RegisterAddr, const uint8_t *pBuffer, uint16_t NumBytes)
+{
+  if (shadow_if_inc == 0U)
+  {
+    /* Only the last byte of a non-incrementing burst sticks */
+    pBuffer += NumBytes - 1U;
+    NumBytes = 1U;
+  }
+
+  for (uint16_t i = 0; i < NumBytes; i++)
+  {
+    uint16_t reg = (uint16_t)RegisterAddr + i;
+
+    if (reg >= LSM6DSOX_SHADOW_FIRST_REG && reg < LSM6DSOX_SHADOW_FIRST_REG + LSM6DSOX_SHADOW_NUM_REGS)
+    {
+      uint16_t bit = (uint16_t)(1U << (reg - LSM6DSOX_SHADOW_FIRST_REG));
+
+      if ((bit & LSM6DSOX_SHADOW_REG_MASK) != 0U)
+      {
+        shadow_regs[reg - LSM6DSOX_SHADOW_FIRST_REG] = pBuffer[i];
+        shadow_valid |= bit;
+      }
+    }
+  }
+}
+
+/**
+ * @brief  Serve a register read from the shadow cache when possible
+ * @param  pBuffer pointer to data to be read.
+ * @param  RegisterAddr specifies internal address register to be read.
+ * @param  NumByteToRead number of bytes to be read.
+ * @retval true if pBuffer was filled from the cache, false if the bus must be read
+ */
+bool LSM6DSOXSensor::Shadow_Lookup(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+{
+  if (Shadow_Cached(RegisterAddr, NumByteToRead))
+  {
+    memcpy(pBuffer, &shadow_regs[RegisterAddr - LSM6DSOX_SHADOW_FIRST_REG], NumByteToRead);
+    shadow_saved++;
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief  Check whether a register write would leave every register unchanged
+ * @param  pBuffer pointer to data to be written.
+ * @param  RegisterAddr specifies internal address register to be written.
+ * @param  NumByteToWrite number of bytes to write.
+ * @retval true if the cache already holds these values and the write can be skipped
+ */
+bool LSM6DSOXSensor::Shadow_Write_Redundant(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+{
+  /* The cache mirrors the user bank only */
+  if (shadow_bank != 0U || !Shadow_Cached(RegisterAddr, NumByteToWrite))
+  {
+    return false;
+  }
+
+  if (memcmp(pBuffer, &shadow_regs[RegisterAddr - LSM6DSOX_SHADOW_FIRST_REG], NumByteToWrite) != 0)
+  {
+    return false;
+  }
+
+  shadow_saved++;
+  return true;
+}
+
+/**
+ * @brief  Check whether every byte of an access is a shadowed register with a valid value
+ * @param  RegisterAddr first register address of the access
+ * @param  NumBytes number of bytes accessed
+ * @retval true if the whole access can be served from the cache
+ */
+bool LSM6DSOXSensor::Shadow_Cached(uint8_t RegisterAddr, uint16_t NumBytes)
+{
+  uint16_t mask = Shadow_Mask(RegisterAddr, NumBytes);
+
+  if (mask == 0U || RegisterAddr < LSM6DSOX_SHADOW_FIRST_REG
+      || (uint16_t)RegisterAddr + NumBytes > LSM6DSOX_SHADOW_FIRST_REG + LSM6DSOX_SHADOW_NUM_REGS
+      || (shadow_if_inc == 0U && NumBytes != 1U))
+  {
+    return false;
+  }
+
+  uint16_t span = (uint16_t)(((1UL << NumBytes) - 1U) << (RegisterAddr - LSM6DSOX_SHADOW_FIRST_REG));
+
+  return mask == span && (shadow_valid & mask) == mask;
+}
+
+/**
+ * @brief  Record the result of a register read that went to the bus
+ * @param  pBuffer data read.
+ * @param  RegisterAddr first register address read.
+ * @param  NumByteToRead number of bytes read.
+ */
+void LSM6DSOXSensor::Shadow_Read_Done(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+{
+  if (Shadow_Mask(RegisterAddr, NumByteToRead) != 0U)
+  {
+    Shadow_Store(RegisterAddr, pBuffer, NumByteToRead);
+    shadow_missed++;
+  }
+}
+
+/**
+ * @brief  Keep the shadow cache and bank tracking in sync with a register write
+ * @param  pBuffer data written.
+ * @param  RegisterAddr first register address written.
+ * @param  NumByteToWrite number of bytes written.
+ * @param  Ok whether the bus write succeeded.
+ */
+void LSM6DSOXSensor::Shadow_Write_Done(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite, bool Ok)
+{
+  if (!Ok)
+  {
+    /* The register state is unknown after a failed write */
+    Invalidate_Shadow();
+    return;
+  }
+
+  /* FUNC_CFG_ACCESS is visible from every bank */
+  if (RegisterAddr == LSM6DSOX_FUNC_CFG_ACCESS)
+  {
+    shadow_bank = pBuffer[0] & 0xC0U;
+    return;
+  }
+
+  if (shadow_bank != 0U)
+  {
+    return;
+  }
+
+  if (RegisterAddr <= LSM6DSOX_CTRL3_C && LSM6DSOX_CTRL3_C < (uint16_t)RegisterAddr + NumByteToWrite)
+  {
+    uint8_t ctrl3_c = pBuffer[shadow_if_inc ? (LSM6DSOX_CTRL3_C - RegisterAddr) : (NumByteToWrite - 1U)];
+
+    /* BOOT and SW_RESET restore the default register values */
+    if ((ctrl3_c & 0x81U) != 0U)
+    {
+      Invalidate_Shadow();
+      shadow_if_inc = 1U;
+      return;
+    }
+
+    shadow_if_inc = (ctrl3_c & 0x04U) ? 1U : 0U;
+  }
+
+  Shadow_Store(RegisterAddr, pBuffer, NumByteToWrite);
+}
+
+/**
+ * @brief  Register read that serves the shadowed control registers from the cache
+ * @param  pBuffer pointer to data to be read.
+ * @param  RegisterAddr specifies internal address register to be read.
+ * @param  NumByteToRead number of bytes to be read.
+ * @retval 0 if ok, an error code otherwise.
+ */
+uint8_t LSM6DSOXSensor::Shadow_IO_Read(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+{
+  if (Shadow_Lookup(pBuffer, RegisterAddr, NumByteToRead))
+  {
+    return 0;
+  }
+
+  if (IO_Read(pBuffer, RegisterAddr, NumByteToRead) != 0)
+  {
+    return 1;
+  }
+
+  Shadow_Read_Done(pBuffer, RegisterAddr, NumByteToRead);
+
+  return 0;
+}
+
+/**
+ * @brief  Register write that keeps the shadow cache and bank tracking in sync
+ * @param  pBuffer pointer to data to be written.
+ * @param  RegisterAddr specifies internal address register to be written.
+ * @param  NumByteToWrite number of bytes to write.
+ * @retval 0 if ok, an error code otherwise.
+ */
+uint8_t LSM6DSOXSensor::Shadow_IO_Write(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+{
+  if (Shadow_Write_Redundant(pBuffer, RegisterAddr, NumByteToWrite))
+  {
+    return 0;
+  }
+
+  bool ok = (IO_Write(pBuffer, RegisterAddr, NumByteToWrite) == 0);
+
+  Shadow_Write_Done(pBuffer, RegisterAddr, NumByteToWrite, ok);
+
+  return ok ? 0 : 1;
 }
 
 int32_t LSM6DSOX_io_write(void *handle, uint8_t WriteAddr, uint8_t *pBuffer, uint16_t nBytesToWrite)
 {
-  return ((LSM6DSOXSensor *)handle)->IO_Write(pBuffer, WriteAddr, nBytesToWrite);
+  return ((LSM6DSOXSensor *)handle)->Shadow_IO_Write(pBuffer, WriteAddr, nBytesToWrite);
 }
 
 int32_t LSM6DSOX_io_read(void *handle, uint8_t ReadAddr, uint8_t *pBuffer, uint16_t nBytesToRead)
 {
-  return ((LSM6DSOXSensor *)handle)->IO_Read(pBuffer, ReadAddr, nBytesToRead);
+  return ((LSM6DSOXSensor *)handle)->Shadow_IO_Read(pBuffer, ReadAddr, nBytesToRead);
 }
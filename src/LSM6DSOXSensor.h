@@ -48,6 +48,7 @@
 #include "Wire.h"
 #include "SPI.h"
 #include "lsm6dsox_reg.h"
+#include "lsm6dsox_bus.h"
 
 /* Defines -------------------------------------------------------------------*/
 /* For compatibility with ESP32 platforms */
@@ -68,6 +69,20 @@
 #define LSM6DSOX_GYRO_SENSITIVITY_FS_1000DPS  35.000f
 #define LSM6DSOX_GYRO_SENSITIVITY_FS_2000DPS  70.000f
 
+/* Control registers mirrored by the shadow cache: FIFO_CTRL1..4, CTRL1_XL, CTRL2_G
+   and CTRL5_C..CTRL7_G. Bit i of the mask stands for LSM6DSOX_SHADOW_FIRST_REG + i. */
+#define LSM6DSOX_SHADOW_FIRST_REG  LSM6DSOX_FIFO_CTRL1
+#define LSM6DSOX_SHADOW_NUM_REGS   16U
+#define LSM6DSOX_SHADOW_REG_MASK   0xE60FU
+
+/* FSM programs go to LSM6DSOX_START_FSM_ADD unless a combined MLC/FSM export places them */
+#define LSM6DSOX_FSM_MAX_PROGRAMS   16U
+
+/* Sensor hub: up to four external I2C slaves, 18 bytes of SENSOR_HUB_x in total */
+#define LSM6DSOX_SH_MAX_SLAVES      4U
+#define LSM6DSOX_SH_MAX_BYTES       18U
+#define LSM6DSOX_SH_WRITE_MARGIN    5U   /* ms past two XL periods before a write cycle times out */
+
 
 /* Typedefs ------------------------------------------------------------------*/
 
@@ -120,6 +135,26 @@ typedef struct {
 } LSM6DSOX_MLC_Status_t;
 
 
+typedef enum
+{
+  LSM6DSOX_FIFO_SENSOR_NONE,
+  LSM6DSOX_FIFO_SENSOR_XL,
+  LSM6DSOX_FIFO_SENSOR_GYRO,
+  LSM6DSOX_FIFO_SENSOR_EXT
+} LSM6DSOX_FIFO_Sensor_t;
+
+typedef struct
+{
+  uint8_t Tag;                    /* FIFO tag of the word */
+  LSM6DSOX_FIFO_Sensor_t Sensor;  /* stream the samples belong to */
+  uint8_t Count;                  /* number of reconstructed samples, 0 to 3 */
+  int16_t Data[3][3];             /* samples oldest first, raw x/y/z counts */
+  uint32_t Timestamp[3];          /* timestamp ticks of the samples, valid if Timestamp_Valid */
+  uint8_t Timestamp_Valid;        /* 1 when batched timestamps cover every sample in the word */
+  uint8_t Slave;                  /* sensor hub slave 0 to 3 for LSM6DSOX_FIFO_SENSOR_EXT */
+} LSM6DSOX_FIFO_Decoded_t;
+
+
 /* Class Declaration ---------------------------------------------------------*/
    
 /**
@@ -132,6 +167,7 @@ class LSM6DSOXSensor
     LSM6DSOXSensor(TwoWire *i2c, uint8_t address=LSM6DSOX_I2C_ADD_H);
     LSM6DSOXSensor(SPIClass *spi, int cs_pin, uint32_t spi_speed=2000000);
     LSM6DSOXStatusTypeDef begin();
+    LSM6DSOXStatusTypeDef Resume();
     LSM6DSOXStatusTypeDef end();
     LSM6DSOXStatusTypeDef ReadID(uint8_t *Id);
     LSM6DSOXStatusTypeDef Enable_X();
@@ -158,6 +194,8 @@ class LSM6DSOXSensor
     
     LSM6DSOXStatusTypeDef Read_Reg(uint8_t reg, uint8_t *Data);
     LSM6DSOXStatusTypeDef Write_Reg(uint8_t reg, uint8_t Data);
+    LSM6DSOXStatusTypeDef Write_Reg_Burst(uint8_t Reg, const uint8_t *Data, uint16_t Len);
+    LSM6DSOXStatusTypeDef Read_Reg_Burst(uint8_t Reg, uint8_t *Data, uint16_t Len);
     LSM6DSOXStatusTypeDef Set_Interrupt_Latch(uint8_t Status);
     
     LSM6DSOXStatusTypeDef Enable_Free_Fall_Detection(LSM6DSOX_SensorIntPin_t IntPin);
@@ -199,6 +237,7 @@ class LSM6DSOXSensor
     
     LSM6DSOXStatusTypeDef Get_X_DRDY_Status(uint8_t *Status);
     LSM6DSOXStatusTypeDef Get_X_Event_Status(LSM6DSOX_Event_Status_t *Status);
+    LSM6DSOXStatusTypeDef Get_All_Sources(lsm6dsox_all_sources_t *Sources);
     LSM6DSOXStatusTypeDef Set_X_SelfTest(uint8_t Status);
     
     LSM6DSOXStatusTypeDef Get_G_DRDY_Status(uint8_t *Status);
@@ -227,11 +266,31 @@ class LSM6DSOXSensor
 
     LSM6DSOXStatusTypeDef Get_MLC_Status(LSM6DSOX_MLC_Status_t *Status);
     LSM6DSOXStatusTypeDef Get_MLC_Output(uint8_t *Output);
+
+    LSM6DSOXStatusTypeDef Load_FSM_Programs(const uint8_t *Programs, uint16_t Len, uint8_t Count, uint16_t StartAddress = LSM6DSOX_START_FSM_ADD);
+    LSM6DSOXStatusTypeDef Enable_FSM(uint16_t Mask);
+    LSM6DSOXStatusTypeDef Disable_FSM();
+    LSM6DSOXStatusTypeDef Set_FSM_ODR(float Odr);
+    LSM6DSOXStatusTypeDef Set_FSM_Long_Counter_Timeout(uint16_t Timeout);
+    LSM6DSOXStatusTypeDef Get_FSM_Long_Counter(uint16_t *Count);
+    LSM6DSOXStatusTypeDef Reset_FSM_Long_Counter();
+    LSM6DSOXStatusTypeDef Get_FSM_Status(uint16_t *Status);
+    LSM6DSOXStatusTypeDef Get_FSM_Output(uint8_t *Output);
+    LSM6DSOXStatusTypeDef Set_FSM_Interrupt(LSM6DSOX_SensorIntPin_t IntPin, uint16_t Mask);
+
+    LSM6DSOXStatusTypeDef Sensor_Hub_Write(uint8_t Address, uint8_t Reg, uint8_t Value);
+    LSM6DSOXStatusTypeDef Sensor_Hub_Config_Slave(uint8_t Slave, uint8_t Address, uint8_t Reg, uint8_t Len);
+    LSM6DSOXStatusTypeDef Sensor_Hub_Enable(uint8_t Slaves, float Odr, uint8_t InternalPullUp = 0);
+    LSM6DSOXStatusTypeDef Sensor_Hub_Disable();
+    LSM6DSOXStatusTypeDef Get_Sensor_Hub_Data(uint8_t *Data, uint8_t Len);
+    LSM6DSOXStatusTypeDef Get_Sensor_Hub_Nack(uint8_t *Nack);
+    LSM6DSOXStatusTypeDef Set_FIFO_Sensor_Hub_Batch(uint8_t Slave, uint8_t Status);
     
     LSM6DSOXStatusTypeDef Get_Timestamp_Status(uint8_t *Status);
     LSM6DSOXStatusTypeDef Set_Timestamp_Status(uint8_t Status);
 
     LSM6DSOXStatusTypeDef Set_FIFO_Timestamp_Decimation(uint8_t Decimation);
+    LSM6DSOXStatusTypeDef Get_Timestamp_Resolution(float *Resolution);
 
     LSM6DSOXStatusTypeDef Set_FIFO_Compression_Algo_Init(uint8_t Status);
 
@@ -241,6 +300,16 @@ class LSM6DSOXSensor
 
     LSM6DSOXStatusTypeDef Set_FIFO_Compression_Algo_Real_Time_Set(uint8_t Status);
 
+    LSM6DSOXStatusTypeDef Enable_FIFO_Compression(uint8_t Compression);
+    LSM6DSOXStatusTypeDef Disable_FIFO_Compression();
+    void Reset_FIFO_Decompressor();
+    LSM6DSOXStatusTypeDef Decode_FIFO_Word(const uint8_t *Word, LSM6DSOX_FIFO_Decoded_t *Decoded);
+
+    LSM6DSOXStatusTypeDef Get_Shadow_Stats(uint32_t *Saved, uint32_t *Missed);
+    void Invalidate_Shadow();
+    uint8_t Shadow_IO_Read(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead);
+    uint8_t Shadow_IO_Write(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite);
+
     /**
      * @brief Utility function to read data.
      * @param  pBuffer: pointer to data to be read.
@@ -251,38 +320,11 @@ class LSM6DSOXSensor
     uint8_t IO_Read(uint8_t* pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
     {        
       if (dev_spi) {
-        dev_spi->beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
-
-        digitalWrite(cs_pin, LOW);
-
-        /* Write Reg Address */
-        dev_spi->transfer(RegisterAddr | 0x80);
-        /* Read the data */
-        for (uint16_t i=0; i<NumByteToRead; i++) {
-          *(pBuffer+i) = dev_spi->transfer(0x00);
-        }
-         
-        digitalWrite(cs_pin, HIGH);
-
-        dev_spi->endTransaction();
-
-        return 0;
+        return LSM6DSOX_SPI_Read(dev_spi, cs_pin, spi_speed, pBuffer, RegisterAddr, NumByteToRead);
       }
 		
       if (dev_i2c) {
-        dev_i2c->beginTransmission(((uint8_t)(((address) >> 1) & 0x7F)));
-        dev_i2c->write(RegisterAddr);
-        dev_i2c->endTransmission(false);
-
-        dev_i2c->requestFrom(((uint8_t)(((address) >> 1) & 0x7F)), (uint8_t) NumByteToRead);
-
-        int i=0;
-        while (dev_i2c->available()) {
-          pBuffer[i] = dev_i2c->read();
-          i++;
-        }
-
-        return 0;
+        return LSM6DSOX_I2C_Read(dev_i2c, ((uint8_t)(((address) >> 1) & 0x7F)), pBuffer, RegisterAddr, NumByteToRead);
       }
 
       return 1;
@@ -298,46 +340,33 @@ class LSM6DSOXSensor
     uint8_t IO_Write(uint8_t* pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
     {  
       if (dev_spi) {
-        dev_spi->beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
-
-        digitalWrite(cs_pin, LOW);
-
-        /* Write Reg Address */
-        dev_spi->transfer(RegisterAddr);
-        /* Write the data */
-        for (uint16_t i=0; i<NumByteToWrite; i++) {
-          dev_spi->transfer(pBuffer[i]);
-        }
-
-        digitalWrite(cs_pin, HIGH);
-
-        dev_spi->endTransaction();
-
-        return 0;                    
+        return LSM6DSOX_SPI_Write(dev_spi, cs_pin, spi_speed, pBuffer, RegisterAddr, NumByteToWrite);
       }
   
       if (dev_i2c) {
-        dev_i2c->beginTransmission(((uint8_t)(((address) >> 1) & 0x7F)));
-
-        dev_i2c->write(RegisterAddr);
-        for (uint16_t i = 0 ; i < NumByteToWrite ; i++) {
-          dev_i2c->write(pBuffer[i]);
-        }
-
-        dev_i2c->endTransmission(true);
-
-        return 0;
+        return LSM6DSOX_I2C_Write(dev_i2c, ((uint8_t)(((address) >> 1) & 0x7F)), pBuffer, RegisterAddr, NumByteToWrite);
       }
 
       return 1;
     }
 
+  protected:
+    LSM6DSOXSensor(lsm6dsox_write_ptr write_reg, lsm6dsox_read_ptr read_reg);
+    bool Shadow_Lookup(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead);
+    bool Shadow_Write_Redundant(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite);
+    void Shadow_Read_Done(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead);
+    void Shadow_Write_Done(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite, bool Ok);
+
   private:
   
     LSM6DSOXStatusTypeDef Set_X_ODR_When_Enabled(float Odr);
     LSM6DSOXStatusTypeDef Set_X_ODR_When_Disabled(float Odr);
     LSM6DSOXStatusTypeDef Set_G_ODR_When_Enabled(float Odr);
     LSM6DSOXStatusTypeDef Set_G_ODR_When_Disabled(float Odr);
+    void Init(lsm6dsox_write_ptr write_reg, lsm6dsox_read_ptr read_reg);
+    uint16_t Shadow_Mask(uint8_t RegisterAddr, uint16_t NumBytes);
+    bool Shadow_Cached(uint8_t RegisterAddr, uint16_t NumBytes);
+    void Shadow_Store(uint8_t RegisterAddr, const uint8_t *pBuffer, uint16_t NumBytes);
   
   
 
@@ -355,12 +384,91 @@ class LSM6DSOXSensor
     
     uint8_t acc_is_enabled;
     uint8_t gyro_is_enabled;
+
+    /* Last reconstructed sample per FIFO stream (XL, gyro) for decompression */
+    int16_t fifo_last[2][3];
+    uint8_t fifo_last_valid[2];
+
+    /* Timestamps of the last three FIFO time slots (t-2, t-1, t) */
+    uint32_t fifo_ts[3];
+    uint8_t fifo_ts_count;
+
+    /* Shadow register cache */
+    uint8_t shadow_regs[LSM6DSOX_SHADOW_NUM_REGS];
+    uint16_t shadow_valid;
+    uint8_t shadow_bank;
+    uint8_t shadow_if_inc;
+    uint32_t shadow_saved;
+    uint32_t shadow_missed;
     
     
     lsm6dsox_ctx_t reg_ctx;
     
 };
 
+/**
+ * LSM6DSOX sensor with the bus fixed at compile time by a policy from
+ * lsm6dsox_bus.h, e.g.
+ *   LSM6DSOXSensorT<LSM6DSOXI2CBus<Wire, LSM6DSOX_I2C_ADD_L> > imu;
+ *   LSM6DSOXSensorT<LSM6DSOXSPIBus<SPI, D10> > imu;   // 10 MHz
+ * The register driver calls the static thunks below, which inline the shadow
+ * cache and the policy transfer, so no per-access bus checks remain.
+ */
+template <class Bus>
+class LSM6DSOXSensorT : public LSM6DSOXSensor
+{
+  public:
+    LSM6DSOXSensorT() : LSM6DSOXSensor(Bus_Write, Bus_Read) {}
+
+    LSM6DSOXStatusTypeDef begin()
+    {
+      Bus::begin();
+      return LSM6DSOXSensor::begin();
+    }
+
+    LSM6DSOXStatusTypeDef Resume()
+    {
+      Bus::begin();
+      return LSM6DSOXSensor::Resume();
+    }
+
+  private:
+    static int32_t Bus_Read(void *handle, uint8_t ReadAddr, uint8_t *pBuffer, uint16_t nBytesToRead)
+    {
+      LSM6DSOXSensorT *self = (LSM6DSOXSensorT *)handle;
+
+      if (self->Shadow_Lookup(pBuffer, ReadAddr, nBytesToRead))
+      {
+        return 0;
+      }
+
+      if (Bus::read(pBuffer, ReadAddr, nBytesToRead) != 0)
+      {
+        return 1;
+      }
+
+      self->Shadow_Read_Done(pBuffer, ReadAddr, nBytesToRead);
+
+      return 0;
+    }
+
+    static int32_t Bus_Write(void *handle, uint8_t WriteAddr, uint8_t *pBuffer, uint16_t nBytesToWrite)
+    {
+      LSM6DSOXSensorT *self = (LSM6DSOXSensorT *)handle;
+
+      if (self->Shadow_Write_Redundant(pBuffer, WriteAddr, nBytesToWrite))
+      {
+        return 0;
+      }
+
+      bool ok = (Bus::write(pBuffer, WriteAddr, nBytesToWrite) == 0);
+
+      self->Shadow_Write_Done(pBuffer, WriteAddr, nBytesToWrite, ok);
+
+      return ok ? 0 : 1;
+    }
+};
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -0,0 +1,104 @@
+#include "b64_stream.h"
+
+static const char b64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+B64Stream::B64Stream() : out(nullptr), capacity(0), raw(0), pos(0), tailLen(0), overflow(false) {
+}
+
+B64Stream::~B64Stream() {
+    if (out != nullptr) {
+        JFree(out);
+    }
+}
+
+bool B64Stream::begin(int rawBytes) {
+    if (out != nullptr) {
+        JFree(out);
+    }
+
+    capacity = ((rawBytes + 2) / 3) * 4;
+    raw = rawBytes;
+    pos = 0;
+    tailLen = 0;
+    overflow = false;
+
+    out = (char*)JMalloc(capacity + 1);
+    return out != nullptr;
+}
+
+void B64Stream::emit(const uint8_t* group, int n) {
+    if (pos + 4 > capacity) {
+        overflow = true;
+        return;
+    }
+
+    uint32_t bits = ((uint32_t)group[0] << 16) |
+                    ((uint32_t)(n > 1 ? group[1] : 0) << 8) |
+                    (uint32_t)(n > 2 ? group[2] : 0);
+
+    out[pos++] = b64Alphabet[(bits >> 18) & 0x3F];
+    out[pos++] = b64Alphabet[(bits >> 12) & 0x3F];
+    out[pos++] = n > 1 ? b64Alphabet[(bits >> 6) & 0x3F] : '=';
+    out[pos++] = n > 2 ? b64Alphabet[bits & 0x3F] : '=';
+}
+
+void B64Stream::write(const void* data, int len) {
+    if (out == nullptr) {
+        return;
+    }
+
+    const uint8_t* in = (const uint8_t*)data;
+
+    // Top up a partial group first, then encode whole groups straight from the input
+    while (len > 0 && tailLen > 0) {
+        tail[tailLen++] = *in++;
+        len--;
+        if (tailLen == 3) {
+            emit(tail, 3);
+            tailLen = 0;
+        }
+    }
+
+    while (len >= 3) {
+        emit(in, 3);
+        in += 3;
+        len -= 3;
+    }
+
+    while (len > 0) {
+        tail[tailLen++] = *in++;
+        len--;
+    }
+}
+
+bool B64Stream::addTo(J* obj, const char* name) {
+    if (out == nullptr) {
+        return false;
+    }
+
+    if (tailLen > 0) {
+        emit(tail, tailLen);
+        tailLen = 0;
+    }
+
+    if (overflow || pos != capacity) {
+        return false;
+    }
+    out[pos] = '\0';
+
+    J* item = JCreateStringReference(out);
+    if (item == nullptr) {
+        return false;
+    }
+    JAddItemToObject(obj, name, item);
+    return true;
+}
+
+int B64Stream::size() {
+    return out != nullptr ? capacity : 0;
+}
+
+int B64Stream::rawSize() {
+    return out != nullptr ? raw : 0;
+}
@@ -0,0 +1,57 @@
+#ifndef B64_STREAM_H
+#define B64_STREAM_H
+
+#include <Arduino.h>
+#include <Notecard.h>
+
+// Streaming base64 writer for note bodies: raw bytes go in through write() and are
+// encoded straight into one JMalloc'd string, sized up front, that the request
+// references. No packed copy of the samples is ever made, so peak heap is the
+// encoded field itself.
+//
+// The request only borrows the string, so the stream must outlive sendRequest().
+
+// Destination for packed payload bytes: a base64 note field, or the Notecard's
+// binary buffer on the card.binary upload path
+class ByteSink {
+public:
+    virtual ~ByteSink() {}
+    virtual void write(const void* data, int len) = 0;
+};
+
+class B64Stream : public ByteSink {
+private:
+    char* out;
+    int capacity;      // encoded characters reserved, without the terminator
+    int raw;           // input bytes the reservation was made for
+    int pos;
+    uint8_t tail[3];   // raw bytes waiting for a full 3-byte group
+    uint8_t tailLen;
+    bool overflow;
+
+    void emit(const uint8_t* group, int n);
+
+public:
+    B64Stream();
+    virtual ~B64Stream();
+
+    // Owns the JMalloc'd string, so a copy would free it twice
+    B64Stream(const B64Stream&) = delete;
+    B64Stream& operator=(const B64Stream&) = delete;
+
+    // Reserve the encoded string for exactly rawBytes of input
+    bool begin(int rawBytes);
+    void write(const void* data, int len);
+
+    // Flush the last group and hang the string off obj as name; fails if the
+    // reservation could not be made or the input did not match it
+    bool addTo(J* obj, const char* name);
+
+    // Encoded length reserved by begin(), 0 before
+    int size();
+
+    // Raw input length given to begin(), 0 before
+    int rawSize();
+};
+
+#endif // B64_STREAM_H
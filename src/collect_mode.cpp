@@ -1,7 +1,56 @@
 #include "collect_mode.h"
 #include "data_mode.h"
 
-CollectMode::CollectMode() : notecard(nullptr), dataMode(nullptr), storedTimestamp(0), hasStoredTimestamp(false) {
+// Raw chunk plus room for the Notecard's COBS framing, encoded in place
+static uint8_t binaryChunk[BINARY_CHUNK_BYTES + BINARY_CHUNK_BYTES / 254 + 16];
+
+// Collects payload bytes into BINARY_CHUNK_BYTES chunks and appends each one to
+// the Notecard binary buffer; note-c sends every chunk with its MD5, which the
+// Notecard checks before accepting it
+class BinaryStoreSink : public ByteSink {
+private:
+    uint32_t fill;
+    uint32_t offset;
+    bool error;
+
+public:
+    BinaryStoreSink() : fill(0), offset(0), error(false) {
+    }
+
+    void write(const void* data, int len) {
+        const uint8_t* in = (const uint8_t*)data;
+        while (len > 0 && !error) {
+            int n = BINARY_CHUNK_BYTES - fill;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(&binaryChunk[fill], in, n);
+            fill += n;
+            in += n;
+            len -= n;
+            if (fill == BINARY_CHUNK_BYTES) {
+                flush();
+            }
+        }
+    }
+
+    bool flush() {
+        if (fill > 0 && !error) {
+            error = NoteBinaryStoreTransmit(binaryChunk, fill, sizeof(binaryChunk), offset) != NULL;
+            offset += fill;
+            fill = 0;
+        }
+        return !error;
+    }
+
+    uint32_t length() {
+        return offset + fill;
+    }
+};
+
+CollectMode::CollectMode() : notecard(nullptr), dataMode(nullptr), storedTimestamp(0), hasStoredTimestamp(false),
+    bulkUpload(false), syncPolicy(nullptr) {
+    memset(&lastUpload, 0, sizeof(lastUpload));
 }
 
 bool CollectMode::begin(Notecard* nc, DataMode* dm) {
@@ -73,170 +122,283 @@ void CollectMode::sendAccelerationData() {
         return;
     }
 
-    int samples = dataMode->getCollectedSamples();
-    if (samples <= 0) {
-        return;
+    // Same capture either way, stamped with the stored UTC timestamp; the bulk
+    // path falls back to sensors.qo notes when it cannot be used
+    unsigned long start = millis();
+    unsigned long bytes = 0;
+    bool binary = bulkUpload && sendCaptureBinary(&bytes);
+    bool ok = binary;
+    unsigned long wireBytes = bytes;
+    if (!binary) {
+        ok = dataMode->sendSamples(storedTimestamp);
+        bytes = dataMode->getLastUploadRawBytes();
+        wireBytes = dataMode->getLastUploadBytes();
     }
 
+    lastUpload.binary = binary;
+    lastUpload.ok = ok;
+    lastUpload.bytes = bytes;
+    lastUpload.wireBytes = wireBytes;
+    lastUpload.ms = millis() - start;
+    lastUpload.bytesPerSec = lastUpload.ms > 0 ? bytes * 1000.0f / lastUpload.ms : 0.0f;
+    lastUpload.timestamp = storedTimestamp;
+}
 
-    // Get data arrays from data_mode
-    float* ax_samples = dataMode->getAxSamples();
-    float* ay_samples = dataMode->getAySamples();
-    float* az_samples = dataMode->getAzSamples();
-
-    // Calculate total size needed
-    int total_size = samples * 12;  // 3 floats * 4 bytes each
+bool CollectMode::sendCaptureBinary(unsigned long* bytes) {
+    CaptureSections sections;
+    if (!dataMode->getCaptureSections(&sections)) {
+        return false;
+    }
+    uint32_t total = sections.dataBytes + sections.tsBytes + sections.extBytes;
 
-    // Create buffer with all data
-    uint8_t* all_data = (uint8_t*)malloc(total_size);
-    if (all_data == NULL) {
-        return;
+    if (NoteBinaryCodecMaxEncodedLength(BINARY_CHUNK_BYTES) > sizeof(binaryChunk)) {
+        return false;
     }
 
-    // Pack all samples into the buffer
-    for (int i = 0; i < samples; i++) {
-        int offset = i * 12;
-        memcpy(&all_data[offset], &ax_samples[i], 4);
-        memcpy(&all_data[offset + 4], &ay_samples[i], 4);
-        memcpy(&all_data[offset + 8], &az_samples[i], 4);
+    // Start from an empty binary buffer and make sure the capture fits in it
+    if (NoteBinaryStoreReset() != NULL) {
+        return false;
     }
 
-    // Base64 encode the entire dataset
-    int encodedLen = ((total_size + 2) / 3) * 4 + 1;
-    char* encoded = (char*)malloc(encodedLen);
-    if (encoded == NULL) {
-        free(all_data);
-        return;
+    J *req = notecard->newRequest("card.binary");
+    if (req == NULL) {
+        return false;
+    }
+    J *rsp = notecard->requestAndResponse(req);
+    if (rsp == NULL) {
+        return false;
+    }
+    uint32_t capacity = notecard->responseError(rsp) ? 0 : (uint32_t)JGetInt(rsp, "max");
+    notecard->deleteResponse(rsp);
+    if (total > capacity) {
+        return false;
     }
 
-    JB64Encode(encoded, (const char*)all_data, total_size);
+    BinaryStoreSink sink;
+    dataMode->writeCaptureSections(sections, sink);
+    if (!sink.flush() || sink.length() != total) {
+        NoteBinaryStoreReset();
+        return false;
+    }
 
-    // Send as regular JSON note with base64 data
-    J *req = notecard->newRequest("note.add");
-    JAddStringToObject(req, "file", "sensors.qo");
-    JAddBoolToObject(req, "sync", true);
+    // The buffer becomes the note's payload; the body says how to split it
+    req = notecard->newRequest("note.add");
+    if (req == NULL) {
+        NoteBinaryStoreReset();
+        return false;
+    }
+    JAddStringToObject(req, "file", CAPTURE_BINARY_FILE);
+    JAddBoolToObject(req, "binary", true);
+    if (syncPolicy == nullptr) {
+        JAddBoolToObject(req, "sync", true);
+    }
 
     J *body = JAddObjectToObject(req, "body");
     if (body) {
-        JAddStringToObject(body, "data", encoded);
-        JAddNumberToObject(body, "samples", samples);
-        JAddNumberToObject(body, "format", 1);  // 1 = float32 ax,ay,az format
-        JAddNumberToObject(body, "rate_hz", dataMode->getCurrentODR());
-        JAddNumberToObject(body, "duration_ms", dataMode->getLoggingDuration());
-        JAddNumberToObject(body, "timestamp", storedTimestamp); // Using stored UTC timestamp
+        JAddNumberToObject(body, "samples", sections.samples);
+        JAddNumberToObject(body, "format", sections.encoder->format());
+        JAddNumberToObject(body, "codec", sections.encoder->codec());
+        JAddNumberToObject(body, "data_len", sections.dataBytes);
+        JAddNumberToObject(body, "ts_len", sections.tsBytes);
+        JAddNumberToObject(body, "ext_len", sections.extBytes);
+        JAddNumberToObject(body, "ext_n", sections.extRecords);
+        dataMode->addCaptureInfo(body, storedTimestamp);
+        if (sections.tsBytes > 0) {
+            dataMode->addTickInfo(body);
+        }
     }
 
-    bool success = notecard->sendRequest(req);
+    rsp = notecard->requestAndResponse(req);
+    bool ok = rsp != NULL && !notecard->responseError(rsp);
+    if (rsp != NULL) {
+        notecard->deleteResponse(rsp);
+    }
+    if (!ok) {
+        NoteBinaryStoreReset();
+        return false;
+    }
 
-    if (success) {
-    } else {
+    if (syncPolicy != nullptr) {
+        syncPolicy->noteAdded(total, NOTE_PRIORITY_BULK, storedTimestamp);
     }
 
-    // Clean up
-    free(all_data);
-    free(encoded);
+    *bytes = total;
+    return true;
 }
 
-void CollectMode::sendTimestampOnly() {
-    if (!hasValidStoredTimestamp()) {
-        return;
+bool CollectMode::registerTemplates() {
+    if (notecard == nullptr) {
+        return false;
     }
 
-
-    // Send just timestamp as JSON note - Format 2
-    J *req = notecard->newRequest("note.add");
-    JAddStringToObject(req, "file", "data.qo");
-    JAddBoolToObject(req, "sync", true);
-
+    // Type hints: 11/12/14/18 are 1/2/4/8-byte integers, 14.1 a 4-byte float.
+    // Epoch seconds fit a signed 4-byte field until 2038.
+    J *req = notecard->newRequest("note.template");
+    if (req == NULL) {
+        return false;
+    }
+    JAddStringToObject(req, "file", STATE_EVENTS_FILE);
     J *body = JAddObjectToObject(req, "body");
     if (body) {
-        JAddNumberToObject(body, "UTCTIMESTAMP", storedTimestamp);
+        JAddNumberToObject(body, "state", 11);
+        JAddNumberToObject(body, "start", 14);
+        JAddNumberToObject(body, "end", 14);
+        JAddNumberToObject(body, "start_ms", 12);
+        JAddNumberToObject(body, "end_ms", 12);
     }
+    bool ok = notecard->sendRequest(req);
 
-    bool success = notecard->sendRequest(req);
-
-    if (success) {
-    } else {
+    req = notecard->newRequest("note.template");
+    if (req == NULL) {
+        return false;
     }
+    JAddStringToObject(req, "file", CAPTURE_BINARY_FILE);
+    body = JAddObjectToObject(req, "body");
+    if (body) {
+        JAddNumberToObject(body, "samples", 14);
+        JAddNumberToObject(body, "format", 11);
+        JAddNumberToObject(body, "codec", 11);
+        JAddNumberToObject(body, "data_len", 14);
+        JAddNumberToObject(body, "ts_len", 14);
+        JAddNumberToObject(body, "ext_len", 14);
+        JAddNumberToObject(body, "ext_n", 12);
+        JAddNumberToObject(body, "scale", 14.1);
+        JAddNumberToObject(body, "gyro_scale", 14.1);
+        JAddNumberToObject(body, "rate_hz", 14.1);
+        JAddNumberToObject(body, "duration_ms", 14);
+        JAddNumberToObject(body, "trigger", 14);
+        JAddNumberToObject(body, "state_from", 11);
+        JAddNumberToObject(body, "state_to", 11);
+        JAddNumberToObject(body, "timestamp", 14);
+        JAddNumberToObject(body, "drains", 14);
+        JAddNumberToObject(body, "awake_ms", 14);
+        JAddNumberToObject(body, "ts0", 18);
+        JAddNumberToObject(body, "ts_lsb_us", 14.1);
+    }
+    ok = notecard->sendRequest(req) && ok;
 
-    // Clear stored timestamp after sending
-    hasStoredTimestamp = false;
-    storedTimestamp = 0;
+    return ok;
 }
 
-void CollectMode::sendStateLog(unsigned long utcTimestamp, unsigned long currentRTCTime) {
+void CollectMode::setBulkUpload(bool enable) {
+    bulkUpload = enable;
+}
 
-    // Use the timestamps directly
-    unsigned long startTime = utcTimestamp;    // When we started data logging
-    unsigned long endTime = currentRTCTime;    // Current RTC time (3 minutes later)
+bool CollectMode::getBulkUpload() {
+    return bulkUpload;
+}
+
+const UploadStats& CollectMode::getLastUpload() {
+    return lastUpload;
+}
+
+bool CollectMode::sendUploadStats() {
+    if (notecard == nullptr || lastUpload.timestamp == 0) {
+        return false;
+    }
 
-    // Send Format 2 with statelog entries
     J *req = notecard->newRequest("note.add");
-    JAddStringToObject(req, "file", "data.qo");
-    JAddBoolToObject(req, "sync", true);
+    if (req == NULL) {
+        return false;
+    }
+    JAddStringToObject(req, "file", UPLOAD_STATS_FILE);
 
     J *body = JAddObjectToObject(req, "body");
     if (body) {
-        // Create simple statelog array with format: [statelog, timestamp, timestamp]
-        J *entries = JCreateArray();
+        JAddBoolToObject(body, "binary", lastUpload.binary);
+        JAddBoolToObject(body, "ok", lastUpload.ok);
+        JAddNumberToObject(body, "bytes", lastUpload.bytes);
+        JAddNumberToObject(body, "wire_bytes", lastUpload.wireBytes);
+        JAddNumberToObject(body, "ms", lastUpload.ms);
+        JAddNumberToObject(body, "bytes_per_s", lastUpload.bytesPerSec);
+        JAddNumberToObject(body, "timestamp", lastUpload.timestamp);
+    }
 
-        // Entry 1: Data logging start (statelog: 0, start_time, start_time)
-        J *entry1 = JCreateArray();
-        JAddItemToArray(entry1, JCreateNumber(0));           // statelog: 0
-        JAddItemToArray(entry1, JCreateNumber(startTime));   // timestamp
-        JAddItemToArray(entry1, JCreateNumber(startTime));   // timestamp again
+    if (!notecard->sendRequest(req)) {
+        return false;
+    }
 
-        // Entry 2: Data logging end (statelog: 0, end_time, end_time)
-        J *entry2 = JCreateArray();
-        JAddItemToArray(entry2, JCreateNumber(0));           // statelog: 0
-        JAddItemToArray(entry2, JCreateNumber(endTime));     // timestamp
-        JAddItemToArray(entry2, JCreateNumber(endTime));     // timestamp again
+    // Never worth a session of its own
+    if (syncPolicy != nullptr) {
+        syncPolicy->noteAdded(UPLOAD_STATS_BYTES, NOTE_PRIORITY_BULK, lastUpload.timestamp);
+    }
+    return true;
+}
 
-        JAddItemToArray(entries, entry1);
-        JAddItemToArray(entries, entry2);
+void CollectMode::setSyncPolicy(SyncPolicy* policy) {
+    syncPolicy = policy;
+}
 
-        JAddItemToObject(body, "entries", entries);
+void CollectMode::stateRecordsAdded(int records, unsigned long epoch) {
+    // One batch of records counts as one note, as it did when they shared an array
+    if (syncPolicy != nullptr) {
+        syncPolicy->noteAdded(records * STATE_RECORD_BYTES, NOTE_PRIORITY_NORMAL, epoch);
     }
+}
 
-    bool success = notecard->sendRequest(req);
+bool CollectMode::addStateRecord(int state, unsigned long start, unsigned long end,
+                                 uint16_t startMs, uint16_t endMs, bool sync) {
+    // One templated data.qo record per state event
+    J *req = notecard->newRequest("note.add");
+    if (req == NULL) {
+        return false;
+    }
+    JAddStringToObject(req, "file", STATE_EVENTS_FILE);
+    if (sync && syncPolicy == nullptr) {
+        JAddBoolToObject(req, "sync", true);
+    }
 
-    if (success) {
-    } else {
+    J *body = JAddObjectToObject(req, "body");
+    if (body) {
+        JAddNumberToObject(body, "state", state);
+        JAddNumberToObject(body, "start", start);
+        JAddNumberToObject(body, "end", end);
+        JAddNumberToObject(body, "start_ms", startMs);
+        JAddNumberToObject(body, "end_ms", endMs);
     }
-}
 
-void CollectMode::sendAllStateEvents(unsigned long* startTimes, unsigned long* endTimes, int* stateLogs, int eventCount) {
+    return notecard->sendRequest(req);
+}
 
-    if (eventCount == 0) {
+void CollectMode::sendTimestampOnly() {
+    if (!hasValidStoredTimestamp()) {
         return;
     }
 
-    // Send Format 2 with all state events
-    J *req = notecard->newRequest("note.add");
-    JAddStringToObject(req, "file", "data.qo");
-    JAddBoolToObject(req, "sync", true);
+    // Marker record (statelog 0) at the stored timestamp
+    addStateRecord(0, storedTimestamp, storedTimestamp, 0, 0, true);
+    stateRecordsAdded(1, storedTimestamp);
 
-    J *body = JAddObjectToObject(req, "body");
-    if (body) {
-        // Create entries array with all state events
-        J *entries = JCreateArray();
+    // Clear stored timestamp after sending
+    hasStoredTimestamp = false;
+    storedTimestamp = 0;
+}
+
+void CollectMode::sendStateLog(unsigned long utcTimestamp, unsigned long currentRTCTime) {
 
-        for (int i = 0; i < eventCount; i++) {
-            // Entry format: [statelog, startTime, endTime]
-            J *entry = JCreateArray();
-            JAddItemToArray(entry, JCreateNumber(stateLogs[i]));
-            JAddItemToArray(entry, JCreateNumber(startTimes[i]));
-            JAddItemToArray(entry, JCreateNumber(endTimes[i]));
-            JAddItemToArray(entries, entry);
+    // Use the timestamps directly
+    unsigned long startTime = utcTimestamp;    // When we started data logging
+    unsigned long endTime = currentRTCTime;    // Current RTC time (3 minutes later)
 
-        }
+    // Data logging start and end markers (statelog 0)
+    addStateRecord(0, startTime, startTime, 0, 0, false);
+    addStateRecord(0, endTime, endTime, 0, 0, true);
+    stateRecordsAdded(2, endTime);
+}
 
-        JAddItemToObject(body, "entries", entries);
-    }
+void CollectMode::sendAllStateEvents(unsigned long* startTimes, unsigned long* endTimes, int* stateLogs, int eventCount,
+                                     uint16_t* startMs, uint16_t* endMs) {
 
-    bool success = notecard->sendRequest(req);
+    if (eventCount == 0) {
+        return;
+    }
 
-    if (success) {
-    } else {
+    // Fixed-length records instead of one JSON array; without a sync policy
+    // only the last asks for a sync
+    for (int i = 0; i < eventCount; i++) {
+        uint16_t sMs = startMs != nullptr ? startMs[i] : 0;
+        uint16_t eMs = endMs != nullptr ? endMs[i] : 0;
+        addStateRecord(stateLogs[i], startTimes[i], endTimes[i], sMs, eMs, i == eventCount - 1);
     }
-}
\ No newline at end of file
+    stateRecordsAdded(eventCount, endTimes[eventCount - 1]);
+}
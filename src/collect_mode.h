@@ -3,10 +3,36 @@
 
 #include <Arduino.h>
 #include <Notecard.h>
+#include "sync_policy.h"
 
 // Forward declaration
 class DataMode;
 
+// Notefiles with a note.template: the Notecard keeps their notes as fixed-length
+// binary records, so every note.add to them must fit the template
+#define STATE_EVENTS_FILE "data.qo"
+#define CAPTURE_BINARY_FILE "captures.qo"
+
+// One note per capture upload with its UploadStats, so both paths can be compared
+#define UPLOAD_STATS_FILE "uploads.qo"
+#define UPLOAD_STATS_BYTES 96  // rough JSON size, for the sync policy's byte count
+
+// Stored size of one templated data.qo record, for the sync policy's byte count
+#define STATE_RECORD_BYTES 13
+
+// card.binary uploads go to the Notecard in chunks of this many raw bytes
+#define BINARY_CHUNK_BYTES 1024
+
+struct UploadStats {
+    bool binary;             // card.binary path, else base64 sensors.qo notes
+    bool ok;
+    unsigned long bytes;     // raw payload bytes, the same measure on both paths
+    unsigned long wireBytes; // as handed to the Notecard: base64 characters on the note path
+    unsigned long ms;
+    float bytesPerSec;       // raw payload bytes
+    unsigned long timestamp; // capture timestamp the upload was stamped with
+};
+
 struct TimestampResult {
     unsigned long unixTime;
     bool success;
@@ -18,11 +44,28 @@ private:
     DataMode* dataMode;
     unsigned long storedTimestamp;
     bool hasStoredTimestamp;
+    bool bulkUpload;
+    UploadStats lastUpload;
+    SyncPolicy* syncPolicy;
 
 public:
     CollectMode();
 
     bool begin(Notecard* nc, DataMode* dm);
+
+    // Register the data.qo and captures.qo templates; call once at boot
+    bool registerTemplates();
+
+    // Bulk mode streams the packed capture into the Notecard binary buffer and
+    // commits it as one captures.qo note, without base64 or JSON parsing.
+    // Captures that do not fit the buffer still go out as sensors.qo notes.
+    void setBulkUpload(bool enable);
+    bool getBulkUpload();
+    const UploadStats& getLastUpload();  // throughput of the last capture upload, either path
+    bool sendUploadStats();              // queue getLastUpload() as an uploads.qo note
+
+    // Queue notes under a sync policy instead of "sync" on every note
+    void setSyncPolicy(SyncPolicy* policy);
     TimestampResult getNotecardTimestamp();
     void storeTimestamp(unsigned long timestamp);
     unsigned long getStoredTimestamp();
@@ -31,11 +74,17 @@ public:
     void sendTimestampOnly();  // Send only timestamp data
     void sendStateLog(unsigned long utcTimestamp, unsigned long currentRTCTime);  // Send statelog format
 
-    // Send state events using simple arrays
-    void sendAllStateEvents(unsigned long* startTimes, unsigned long* endTimes, int* stateLogs, int eventCount);
+    // Send state events as one templated data.qo record each; startMs/endMs
+    // (optional) are the millisecond parts of the times
+    void sendAllStateEvents(unsigned long* startTimes, unsigned long* endTimes, int* stateLogs, int eventCount,
+                            uint16_t* startMs = nullptr, uint16_t* endMs = nullptr);
 
 private:
     void sendAccelerationData();  // For now, just acceleration data
+    bool sendCaptureBinary(unsigned long* bytes);
+    bool addStateRecord(int state, unsigned long start, unsigned long end,
+                        uint16_t startMs, uint16_t endMs, bool sync);
+    void stateRecordsAdded(int records, unsigned long epoch);
 };
 
 #endif // COLLECT_MODE_H
\ No newline at end of file
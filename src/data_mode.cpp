@@ -1,19 +1,27 @@
 #include "data_mode.h"
 #include "LSM6DSOXSensor.h"
-#include "onoff.h"
+#include "ucf_loader.h"
 
 // LSM6DSOX I2C addresses
 #define LSM6DSOX_ADDRESS_LOW  0x6A
 #define LSM6DSOX_ADDRESS_HIGH 0x6B
 #define LSM6DSOX_WHO_AM_I_VALUE 0x6C
 
-// Components
-LSM6DSOXSensor AccGyr(&Wire, LSM6DSOX_I2C_ADD_L);
+// Components. The bus is fixed at compile time so register access inlines;
+// boards with the sensor on SPI can use LSM6DSOXSPIBus<SPI, cs> (10 MHz) instead
+LSM6DSOXSensorT<LSM6DSOXI2CBus<Wire, LSM6DSOX_I2C_ADD_L> > AccGyr;
+LSM6DSOXAsync AccGyrAsync(&AccGyr, LSM6DSOX_I2C_ADD_L);
 
-// MLC variables
-ucf_line_t *ProgramPointer;
-int32_t LineCounter;
-int32_t TotalNumberOfLine;
+// Capture profiles, indexed by CaptureProfileId
+static const CaptureProfile captureProfiles[PROFILE_COUNT] = {
+    { 26.0f,   2, 10000, 260,  PAYLOAD_FORMAT_DELTA_VARINT },
+    { 416.0f,  4, 5000,  2080, PAYLOAD_FORMAT_AUTO },
+    { 1666.0f, 8, 2000,  3332, PAYLOAD_FORMAT_AUTO },
+};
+
+// Operating point shared by the MLC programs (onoff.h, movement.h), restored after every capture
+#define MLC_ODR_HZ 26.0f
+#define MLC_FS_G 2
 
 // Data variables
 uint8_t lsm6dsox_address = 0;
@@ -21,7 +29,25 @@ bool lsm6dsox_found = false;
 
 DataMode::DataMode() : initialized(false), accelerometerReady(false), lastSample(0),
     isLogging(false), loggingStartTime(0), current_odr(26.0f),
-    logging_duration(10000), collected_samples(0), notecard(nullptr), currentModePtr(nullptr), utcTimestamp(0), accelerometer(nullptr) {
+    logging_duration(10000), current_fs(MLC_FS_G), sampleBudget(260), profile(PROFILE_MLC_26HZ),
+    captureMode(CAPTURE_MODE_POLLED), activeCaptureMode(CAPTURE_MODE_POLLED), captureSensitivity(0.0f), gyroSensitivity(0.0f),
+    targetSamples(0), fifoIntEnabled(false), fifoIntPin(LSM6DSOX_INT1_PIN),
+    fifoCompression(LSM6DSOX_CMP_DISABLE), fifoTimestamps(false), captureTimestamps(false), tickResolutionUs(25.0f),
+    firstTick(0), lastTick(0), tickDeltas(nullptr), extSlaves(0), extSamples(nullptr), ext_samples(0), ringOdr(PRETRIGGER_ODR_HZ), ringPreMs(PRETRIGGER_PRE_MS),
+    ringPostMs(PRETRIGGER_POST_MS), ringArmed(false), waveformActive(false), triggerIndex(0),
+    triggerFrom(0), triggerTo(0), fifoDrains(0),
+    captureAwakeMs(0), storageSetting(STORAGE_FLOAT32), storage(STORAGE_FLOAT32), collected_samples(0), gyro_samples(0), notecard(nullptr), currentModePtr(nullptr), utcTimestamp(0), accelerometer(nullptr),
+    mlcLoadPending(false), asyncSensor(nullptr), mlcEventRequested(false), payloadFormat(PAYLOAD_FORMAT_AUTO), uploadBytes(0), uploadRawBytes(0), syncPolicy(nullptr) {
+
+    memset(&mlcLoad, 0, sizeof(mlcLoad));
+    memset(&imuRestore, 0, sizeof(imuRestore));
+    memset(&mlcEvent, 0, sizeof(mlcEvent));
+    memset(mlcEventTicks, 0, sizeof(mlcEventTicks));
+    memset(extSensors, 0, sizeof(extSensors));
+    mlcEventOutputs.done = false;
+    mlcEventOutputs.status = LSM6DSOX_OK;
+    mlcEventTimestamp.done = false;
+    mlcEventTimestamp.status = LSM6DSOX_OK;
 
     // Calculate sample interval from ODR
     sample_interval_ms = (unsigned long)(1000.0f / current_odr);
@@ -32,6 +58,16 @@ bool DataMode::begin(Notecard* nc) {
     // Store notecard reference
     notecard = nc;
 
+    // Built-in wire formats, in PAYLOAD_FORMAT_AUTO fallback order. Registered
+    // here rather than in the constructor: DataMode is a global too, and the
+    // encoders in payload_encoder.cpp need not be constructed before it.
+    // A second begin() finds them registered already.
+    payloads.registerEncoder(&float32Payload);
+    payloads.registerEncoder(&int16Payload);
+    payloads.registerEncoder(&int16SixAxisPayload);
+    payloads.registerEncoder(&deltaVarintPayload);
+    payloads.registerEncoder(&deltaVarintPlanarPayload);
+
     // Initialize I2C
     Wire.begin();
     Wire.setClock(400000);
@@ -57,7 +93,11 @@ void DataMode::update() {
 
     // Handle logging (should always be active in this mode)
     if (isLogging) {
-        logAccelerationData();
+        if (activeCaptureMode == CAPTURE_MODE_FIFO) {
+            drainFifo();
+        } else {
+            logAccelerationData();
+        }
     }
     // Don't auto-restart - let it switch to collect mode after completion
 }
@@ -68,6 +108,21 @@ bool DataMode::isAccelerometerReady() {
 
 bool DataMode::initializeAccelerometer() {
 
+    // MLC programs for motion detection, in MlcModelId order
+    mlcModels.begin(&AccGyr);
+    mlcModels.registerModel(&UCF_ONOFF);
+    mlcModels.registerModel(&UCF_MOVEMENT);
+    imuEvents.begin(&AccGyr);
+
+    // Warm boot: the sensor kept power through an MCU reset, so only
+    // registers that drifted from the saved snapshot get rewritten
+    if (resumeAccelerometer()) {
+        accelerometer = &AccGyr;
+        asyncSensor = &AccGyrAsync;
+        mlcLoadPending = true;
+        return true;
+    }
+
     // Try to initialize the sensor using the library
     if (AccGyr.begin() != LSM6DSOX_OK) {
         return false;
@@ -81,32 +136,72 @@ bool DataMode::initializeAccelerometer() {
 
 
     // Set accelerometer configuration: 26Hz, ±2g (like in previous example)
-    if (AccGyr.Set_X_ODR(26.0f) != LSM6DSOX_OK) {
+    if (!applyCaptureConfig(MLC_ODR_HZ, MLC_FS_G)) {
         return false;
     }
 
-    if (AccGyr.Set_X_FS(2) != LSM6DSOX_OK) {
+
+    // Load MLC configuration; the embedded part is skipped when the sensor
+    // still runs it from before an MCU-only reset
+    if (!mlcModels.load(MLC_MODEL_ONOFF)) {
         return false;
     }
+    mlcLoad = mlcModels.getLastReport();
 
+    // The timestamp counter runs while the MLC is armed, so MLC events carry sensor ticks
+    if (AccGyr.Set_Timestamp_Status(1) != LSM6DSOX_OK) {
+        return false;
+    }
 
-    // Load MLC configuration for motion detection
 
-    ProgramPointer = (ucf_line_t *)onoff;
-    TotalNumberOfLine = sizeof(onoff) / sizeof(ucf_line_t);
+    // Store accelerometer reference for MLC state reading
+    accelerometer = &AccGyr;
+    asyncSensor = &AccGyrAsync;
 
-    for (LineCounter = 0; LineCounter < TotalNumberOfLine; LineCounter++) {
-        if (AccGyr.Write_Reg(ProgramPointer[LineCounter].address, ProgramPointer[LineCounter].data)) {
-            return false;
-        }
+    if (!mlcLoad.skipped) {
+        delay(100); // Allow sensor to stabilize
     }
+    mlcLoadPending = true;
 
+    // Remember this configuration for the next warm boot
+    saveImuSnapshot();
 
-    // Store accelerometer reference for MLC state reading
-    accelerometer = &AccGyr;
+    return true;
+}
+
+void DataMode::saveImuSnapshot() {
+    // A failed read would leave the previous image describing a different setup
+    if (!imuSnapshotSave(AccGyr, (uint8_t)mlcModels.getActive(), mlcModels.getActiveChecksum())) {
+        imuSnapshotClear();
+    }
+}
+
+bool DataMode::resumeAccelerometer() {
+    unsigned long start = micros();
+    ImuSnapshot snapshot;
 
-    delay(100); // Allow sensor to stabilize
+    imuRestore.warm = false;
+    imuRestore.restored = 0;
 
+    if (!imuSnapshotLoad(&snapshot)) {
+        return false;
+    }
+
+    // Driver state from the live registers, then the MLC program against flash
+    if (AccGyr.Resume() != LSM6DSOX_OK) {
+        return false;
+    }
+    if (!mlcModels.resume(snapshot.model, snapshot.mlcChecksum)) {
+        return false;
+    }
+
+    if (!imuSnapshotRestore(AccGyr, snapshot, &imuRestore.restored)) {
+        return false;
+    }
+
+    imuRestore.warm = true;
+    imuRestore.durationUs = micros() - start;
+    mlcLoad = mlcModels.getLastReport();
     return true;
 }
 
@@ -126,10 +221,48 @@ void DataMode::readAndPrintAcceleration() {
 
 void DataMode::startLogging() {
 
+    // The capture reprograms ODR, FIFO and gyro; a reset inside the window
+    // has to take the cold path instead of restoring half of it
+    imuSnapshotClear();
+
+    // A capture owns the FIFO; the ring has to be re-armed afterwards
+    if (ringArmed) {
+        disarmPreTrigger();
+    }
+
     isLogging = true;
     loggingStartTime = millis();
     collected_samples = 0;
+    gyro_samples = 0;
+    ext_samples = 0;
     lastSample = 0;
+    fifoDrains = 0;
+    captureAwakeMs = 0;
+
+    // Profiles other than the MLC operating point reprogram the accelerometer for the window
+    if (accelerometerReady && (current_odr != MLC_ODR_HZ || current_fs != MLC_FS_G)) {
+        applyCaptureConfig(current_odr, current_fs);
+    }
+
+    // Full scale does not change during a capture, so read the sensitivity once
+    if (accelerometerReady) {
+        AccGyr.Get_X_Sensitivity(&captureSensitivity);
+    }
+
+    // The MLC only needs the accelerometer, so the gyro runs for six-axis captures
+    // only; without it this capture keeps accel counts and the next one retries
+    storage = storageSetting;
+    if (storage == STORAGE_RAW_6AXIS && !startGyroCapture()) {
+        storage = STORAGE_RAW_INT16;
+    }
+
+    // Fall back to polling for this capture if the FIFO could not be programmed;
+    // the next one tries the configured mode again
+    CaptureMode mode = captureMode;
+    if (mode == CAPTURE_MODE_FIFO && !startFifoCapture()) {
+        mode = CAPTURE_MODE_POLLED;
+    }
+    activeCaptureMode = mode;
 
     digitalWrite(LED_BUILTIN, HIGH);
 }
@@ -138,6 +271,26 @@ void DataMode::stopLogging() {
     isLogging = false;
     digitalWrite(LED_BUILTIN, LOW);
 
+    if (activeCaptureMode == CAPTURE_MODE_FIFO) {
+        stopFifoCapture();
+    }
+
+    if (storage == STORAGE_RAW_6AXIS) {
+        AccGyr.Disable_G();
+    }
+
+    // The MLC decision tree was trained at 26 Hz / 2 g
+    if (accelerometerReady && (current_odr != MLC_ODR_HZ || current_fs != MLC_FS_G)) {
+        applyCaptureConfig(MLC_ODR_HZ, MLC_FS_G);
+    }
+
+    if (accelerometerReady) {
+        saveImuSnapshot();
+    }
+
+    // millis() is held while the MCU deep sleeps, so this is the awake time only
+    captureAwakeMs = millis() - loggingStartTime;
+
 
     // Send all samples to cloud
     sendSamplesToCloud();
@@ -161,95 +314,598 @@ void DataMode::logAccelerationData() {
     }
 
     // Check if we've collected maximum samples
-    if (collected_samples >= MAX_SAMPLES) {
+    if (collected_samples >= getSampleCapacity() || collected_samples >= sampleBudget) {
         stopLogging();
         return;
     }
 
     // Sample at the specified interval
     if (millis() - lastSample >= sample_interval_ms) {
-        int32_t accelerometer[3];
+        int16_t raw[3];
+
+        if (AccGyr.Get_X_AxesRaw(raw) == LSM6DSOX_OK) {
+            storeSample(raw);
+
+            // Keep the gyro plane paired with the accel plane by index
+            if (storage == STORAGE_RAW_6AXIS) {
+                if (AccGyr.Get_G_AxesRaw(raw) != LSM6DSOX_OK) {
+                    raw[0] = raw[1] = raw[2] = 0;
+                }
+                storeGyroSample(raw);
+            }
+        }
+
+        lastSample = millis();
+    }
+}
+
+bool DataMode::startFifoCapture() {
+    if (!accelerometerReady) {
+        return false;
+    }
+
+    // The window is bounded by sample count rather than millis(), which does
+    // not advance while the MCU deep sleeps between drains
+    targetSamples = (int)(current_odr * logging_duration / 1000.0f);
+    if (targetSamples > sampleBudget) {
+        targetSamples = sampleBudget;
+    }
+    if (targetSamples > getSampleCapacity()) {
+        targetSamples = getSampleCapacity();
+    }
+
+    // Bypass flushes anything left over from a previous capture
+    if (AccGyr.Set_FIFO_Mode(LSM6DSOX_BYPASS_MODE) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_X_BDR(current_odr) != LSM6DSOX_OK) {
+        return false;
+    }
 
-        if (AccGyr.Get_X_Axes(accelerometer) == LSM6DSOX_OK) {
-            // Convert to float and store in arrays (mg values)
-            ax_samples[collected_samples] = (float)accelerometer[0];
-            ay_samples[collected_samples] = (float)accelerometer[1];
-            az_samples[collected_samples] = (float)accelerometer[2];
+    if (AccGyr.Set_FIFO_G_BDR(storage == STORAGE_RAW_6AXIS ? current_odr : 0.0f) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (extSlaves > 0 && !startExternalCapture()) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_Watermark_Level(FIFO_WATERMARK_WORDS) != LSM6DSOX_OK) {
+        return false;
+    }
 
+    // Timestamps only cost RAM once a capture asks for them; without the
+    // buffer this capture simply goes out without them
+    captureTimestamps = false;
+    if (fifoTimestamps && tickDeltas == nullptr) {
+        tickDeltas = (uint16_t*)malloc(MAX_RAW_SAMPLES * sizeof(uint16_t));
+    }
 
-            collected_samples++;
+    // One timestamp word per time slot gives every sample its own tick
+    if (fifoTimestamps && tickDeltas != nullptr) {
+        captureTimestamps = true;
+        if (AccGyr.Set_Timestamp_Status(1) != LSM6DSOX_OK) {
+            return false;
         }
+        if (AccGyr.Set_FIFO_Timestamp_Decimation(LSM6DSOX_DEC_1) != LSM6DSOX_OK) {
+            return false;
+        }
+        AccGyr.Get_Timestamp_Resolution(&tickResolutionUs);
+    }
 
-        lastSample = millis();
+    // Compression restarts on an uncompressed word, so the decoder starts clean
+    if (fifoCompression != LSM6DSOX_CMP_DISABLE &&
+        AccGyr.Enable_FIFO_Compression(fifoCompression) != LSM6DSOX_OK) {
+        return false;
+    }
+    AccGyr.Reset_FIFO_Decompressor();
+
+    if (fifoIntEnabled && setFifoThresholdRoute(1) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_Mode(LSM6DSOX_STREAM_MODE) != LSM6DSOX_OK) {
+        return false;
     }
+
+    return true;
 }
 
-void DataMode::sendSamplesToCloud() {
-    if (collected_samples == 0) {
+void DataMode::stopFifoCapture() {
+    if (!accelerometerReady) {
         return;
     }
 
-    if (notecard == nullptr) {
+    // Stop batching and discard whatever is still queued
+    AccGyr.Set_FIFO_X_BDR(0.0f);
+    AccGyr.Set_FIFO_G_BDR(0.0f);
+    if (extSlaves > 0) {
+        stopExternalCapture();
+    }
+    AccGyr.Set_FIFO_Mode(LSM6DSOX_BYPASS_MODE);
+
+    if (fifoCompression != LSM6DSOX_CMP_DISABLE) {
+        AccGyr.Disable_FIFO_Compression();
+    }
+
+    // The counter itself keeps running for MLC events
+    if (captureTimestamps) {
+        AccGyr.Set_FIFO_Timestamp_Decimation(LSM6DSOX_NO_DECIMATION);
+    }
+
+    if (fifoIntEnabled) {
+        setFifoThresholdRoute(0);
+    }
+}
+
+LSM6DSOXStatusTypeDef DataMode::setFifoThresholdRoute(uint8_t enable) {
+    if (fifoIntPin == LSM6DSOX_INT2_PIN) {
+        return AccGyr.Set_FIFO_INT2_FIFO_Threshold(enable);
+    }
+    return AccGyr.Set_FIFO_INT1_FIFO_Threshold(enable);
+}
+
+void DataMode::drainFifo() {
+    uint16_t level = 0;
+    if (AccGyr.Get_FIFO_Num_Samples(&level) != LSM6DSOX_OK) {
+        return;
+    }
+
+    if (level == 0) {
         return;
     }
+    fifoDrains++;
 
-    writeBinaryData();
+    static uint8_t words[FIFO_DRAIN_WORDS * 7];
+
+    while (level > 0 && !captureFull()) {
+        uint16_t count = level > FIFO_DRAIN_WORDS ? FIFO_DRAIN_WORDS : level;
+
+        if (AccGyr.Get_FIFO_Sample(words, count) != LSM6DSOX_OK) {
+            return;
+        }
+        level -= count;
+
+        for (uint16_t i = 0; i < count && !captureFull(); i++) {
+            // Every word goes through the decoder so compressed deltas stay in sequence
+            LSM6DSOX_FIFO_Decoded_t decoded;
+            if (AccGyr.Decode_FIFO_Word(&words[i * 7], &decoded) != LSM6DSOX_OK) {
+                continue;
+            }
+
+            // Sensor hub words are kept apart, tagged with the accel sample they follow
+            if (decoded.Sensor == LSM6DSOX_FIFO_SENSOR_EXT) {
+                storeExtSample(decoded);
+                continue;
+            }
+
+            // Gyro words are de-interleaved into their own planes by tag
+            if (decoded.Sensor == LSM6DSOX_FIFO_SENSOR_GYRO && storage == STORAGE_RAW_6AXIS) {
+                for (uint8_t n = 0; n < decoded.Count && gyro_samples < targetSamples; n++) {
+                    storeGyroSample(decoded.Data[n]);
+                }
+                continue;
+            }
+
+            if (decoded.Sensor != LSM6DSOX_FIFO_SENSOR_XL) {
+                continue;
+            }
+
+            for (uint8_t n = 0; n < decoded.Count && collected_samples < targetSamples; n++) {
+                if (captureTimestamps) {
+                    storeTick(decoded.Timestamp[n], decoded.Timestamp_Valid);
+                }
+                storeSample(decoded.Data[n]);
+            }
+        }
+    }
+
+    if (captureFull()) {
+        stopLogging();
+    }
 }
 
-void DataMode::writeBinaryData() {
-    // Send acceleration data as base64-encoded JSON note (same as previous example)
+bool DataMode::startExternalCapture() {
+    for (uint8_t slave = 0; slave < extSlaves; slave++) {
+        if (AccGyr.Set_FIFO_Sensor_Hub_Batch(slave, 1) != LSM6DSOX_OK) {
+            return false;
+        }
+    }
 
-    // Calculate total size needed
-    int total_size = collected_samples * 12;  // 3 floats * 4 bytes each
+    // The hub runs off the accelerometer data-ready, so it never outpaces the capture
+    return AccGyr.Sensor_Hub_Enable(extSlaves, current_odr) == LSM6DSOX_OK;
+}
+
+void DataMode::stopExternalCapture() {
+    AccGyr.Sensor_Hub_Disable();
+    for (uint8_t slave = 0; slave < extSlaves; slave++) {
+        AccGyr.Set_FIFO_Sensor_Hub_Batch(slave, 0);
+    }
+}
 
-    // Create buffer with all data
-    uint8_t* all_data = (uint8_t*)malloc(total_size);
-    if (all_data == NULL) {
+void DataMode::storeExtSample(const LSM6DSOX_FIFO_Decoded_t& decoded) {
+    if (extSamples == nullptr || ext_samples >= MAX_EXT_SAMPLES) {
         return;
     }
 
-    // Pack all samples into the buffer
-    for (int i = 0; i < collected_samples; i++) {
-        int offset = i * 12;
-        memcpy(&all_data[offset], &ax_samples[i], 4);
-        memcpy(&all_data[offset + 4], &ay_samples[i], 4);
-        memcpy(&all_data[offset + 8], &az_samples[i], 4);
+    ExtSample& ext = extSamples[ext_samples++];
+    ext.slave = decoded.Slave;
+    ext.at = (uint16_t)collected_samples;
+    memcpy(ext.data, decoded.Data[0], sizeof(ext.data));
+}
+
+bool DataMode::captureFull() {
+    if (storage == STORAGE_RAW_6AXIS && gyro_samples < targetSamples) {
+        return false;
+    }
+    return collected_samples >= targetSamples;
+}
+
+bool DataMode::startGyroCapture() {
+    if (!accelerometerReady) {
+        return false;
+    }
+
+    if (AccGyr.Set_G_ODR(current_odr) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_G_FS(GYRO_CAPTURE_FS_DPS) != LSM6DSOX_OK) {
+        return false;
     }
 
-    // Base64 encode the entire dataset
-    int encodedLen = ((total_size + 2) / 3) * 4 + 1;
-    char* encoded = (char*)malloc(encodedLen);
-    if (encoded == NULL) {
-        free(all_data);
+    if (AccGyr.Enable_G() != LSM6DSOX_OK) {
+        return false;
+    }
+
+    AccGyr.Get_G_Sensitivity(&gyroSensitivity);
+    return true;
+}
+
+void DataMode::storeSample(const int16_t* raw) {
+    if (storage == STORAGE_RAW_6AXIS) {
+        samples.raw6[0][collected_samples] = raw[0];
+        samples.raw6[1][collected_samples] = raw[1];
+        samples.raw6[2][collected_samples] = raw[2];
+    } else if (storage == STORAGE_RAW_INT16) {
+        samples.raw[0][collected_samples] = raw[0];
+        samples.raw[1][collected_samples] = raw[1];
+        samples.raw[2][collected_samples] = raw[2];
+    } else {
+        // Same mg truncation as Get_X_Axes()
+        samples.mg.ax[collected_samples] = (float)(int32_t)((float)raw[0] * captureSensitivity);
+        samples.mg.ay[collected_samples] = (float)(int32_t)((float)raw[1] * captureSensitivity);
+        samples.mg.az[collected_samples] = (float)(int32_t)((float)raw[2] * captureSensitivity);
+    }
+
+    collected_samples++;
+}
+
+void DataMode::storeGyroSample(const int16_t* raw) {
+    samples.raw6[3][gyro_samples] = raw[0];
+    samples.raw6[4][gyro_samples] = raw[1];
+    samples.raw6[5][gyro_samples] = raw[2];
+
+    gyro_samples++;
+}
+
+void DataMode::storeTick(uint32_t tick, bool valid) {
+    // Called before storeSample(), so collected_samples indexes the new sample
+    if (!valid) {
+        tickDeltas[collected_samples] = TICK_DELTA_UNKNOWN;
         return;
     }
 
-    JB64Encode(encoded, (const char*)all_data, total_size);
+    if (collected_samples == 0) {
+        firstTick = tick;
+        tickDeltas[0] = 0;
+    } else {
+        // Unsigned subtraction handles the 32-bit counter wrapping
+        uint32_t delta = tick - lastTick;
+        tickDeltas[collected_samples] = delta < TICK_DELTA_UNKNOWN ? (uint16_t)delta : TICK_DELTA_UNKNOWN;
+    }
+    lastTick = tick;
+}
+
+bool DataMode::applyCaptureConfig(float odr, int32_t fullScale) {
+    if (AccGyr.Set_X_ODR(odr) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_X_FS(fullScale) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    return true;
+}
+
+void DataMode::sendSamplesToCloud() {
+    sendSamples(utcTimestamp);
+}
+
+bool DataMode::sendSamples(unsigned long timestamp) {
+    int count = getCollectedSamples();
+    if (count == 0) {
+        return true;
+    }
+
+    if (notecard == nullptr) {
+        return false;
+    }
+
+    uploadBytes = 0;
+    uploadRawBytes = 0;
+
+    // Each note's encoded fields are bounded by the chunk size, not the capture length
+    int chunks = (count + UPLOAD_CHUNK_SAMPLES - 1) / UPLOAD_CHUNK_SAMPLES;
+    bool ok = true;
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        int first = chunk * UPLOAD_CHUNK_SAMPLES;
+        int n = count - first < UPLOAD_CHUNK_SAMPLES ? count - first : UPLOAD_CHUNK_SAMPLES;
+        unsigned long before = uploadBytes;
+        if (!writeBinaryData(timestamp, first, n, chunk, chunks)) {
+            ok = false;
+            continue;
+        }
+
+        // Transition waveforms sync once, with their last chunk
+        if (syncPolicy != nullptr) {
+            NotePriority priority = waveformActive && chunk == chunks - 1 ? NOTE_PRIORITY_URGENT : NOTE_PRIORITY_BULK;
+            syncPolicy->noteAdded(uploadBytes - before, priority, timestamp);
+        }
+    }
+    return ok;
+}
+
+bool DataMode::writeBinaryData(unsigned long timestamp, int first, int count, int chunk, int chunks) {
+    // Samples are base64-encoded straight from the capture arrays into the note's
+    // field strings; these must stay alive until the request has been sent
+    B64Stream data;
+    B64Stream ts;
+    B64Stream ext;
+
+    PayloadSource src = getPayloadSource();
+    const PayloadEncoder* encoder = selectPayloadEncoder(src);
+    if (encoder == nullptr) {
+        return false;
+    }
+
+    if (!data.begin(encoder->encodedSize(src, first, count))) {
+        return false;
+    }
+    encoder->encode(src, first, count, data);
 
-    // Send as regular JSON note with base64 data
     J *req = notecard->newRequest("note.add");
+    if (req == NULL) {
+        return false;
+    }
     JAddStringToObject(req, "file", "sensors.qo");
-    JAddBoolToObject(req, "sync", true);
+    if (syncPolicy == nullptr) {
+        JAddBoolToObject(req, "sync", true);
+    }
 
     J *body = JAddObjectToObject(req, "body");
-    if (body) {
-        JAddStringToObject(body, "data", encoded);
-        JAddNumberToObject(body, "samples", collected_samples);
-        JAddNumberToObject(body, "format", 1);  // 1 = float32 ax,ay,az format
+    bool ok = body != NULL && data.addTo(body, "data");
+    if (ok) {
+        JAddNumberToObject(body, "samples", count);
+        JAddNumberToObject(body, "format", encoder->format());
+        JAddNumberToObject(body, "codec", encoder->codec());
+        addCaptureInfo(body, timestamp);
+        if (chunks > 1) {
+            JAddNumberToObject(body, "chunk", chunk);
+            JAddNumberToObject(body, "chunks", chunks);
+            JAddNumberToObject(body, "first", first);
+        }
+        if (hasSampleTimestamps()) {
+            ok = ok && addSampleTimestamps(body, ts, first, count);
+        }
+        if (ext_samples > 0 && !waveformActive) {
+            ok = ok && addExternalSamples(body, ext, first, count);
+        }
+
+        // Boot cost of the MLC program, reported once with the next upload
+        if (ok && mlcLoadPending) {
+            J *mlc = JAddObjectToObject(body, "mlc_load");
+            if (mlc) {
+                JAddBoolToObject(mlc, "skipped", mlcLoad.skipped);
+                JAddBoolToObject(mlc, "verified", mlcLoad.verified);
+                JAddNumberToObject(mlc, "checksum", mlcLoad.checksum);
+                JAddNumberToObject(mlc, "writes", mlcLoad.writes);
+                JAddNumberToObject(mlc, "us", mlcLoad.durationUs);
+                JAddStringToObject(mlc, "model", mlcModels.getActiveName());
+                JAddBoolToObject(mlc, "warm", imuRestore.warm);
+                if (imuRestore.warm) {
+                    JAddNumberToObject(mlc, "restored", imuRestore.restored);
+                    JAddNumberToObject(mlc, "warm_us", imuRestore.durationUs);
+                }
+            }
+            mlcLoadPending = false;
+        }
+    }
+
+    // A note missing its data would look like a valid, empty capture
+    if (!ok) {
+        JDelete(req);
+        return false;
+    }
+
+    uploadBytes += data.size() + ts.size() + ext.size();
+    uploadRawBytes += data.rawSize() + ts.rawSize() + ext.rawSize();
+    return notecard->sendRequest(req);
+}
+
+void DataMode::setSyncPolicy(SyncPolicy* policy) {
+    syncPolicy = policy;
+}
+
+unsigned long DataMode::getLastUploadBytes() {
+    return uploadBytes;
+}
+
+unsigned long DataMode::getLastUploadRawBytes() {
+    return uploadRawBytes;
+}
+
+void DataMode::addCaptureInfo(J* body, unsigned long timestamp) {
+    if (storage != STORAGE_FLOAT32) {
+        JAddNumberToObject(body, "scale", captureSensitivity);  // mg per LSB
+    }
+    if (storage == STORAGE_RAW_6AXIS) {
+        JAddNumberToObject(body, "gyro_scale", gyroSensitivity);  // mdps per LSB
+    }
+    if (waveformActive) {
+        // MLC transition waveform: trigger is the sample index of the D6 wake
+        JAddNumberToObject(body, "rate_hz", ringOdr);
+        JAddNumberToObject(body, "duration_ms", ringPreMs + ringPostMs);
+        JAddNumberToObject(body, "trigger", triggerIndex);
+        JAddNumberToObject(body, "state_from", triggerFrom);
+        JAddNumberToObject(body, "state_to", triggerTo);
+    } else {
         JAddNumberToObject(body, "rate_hz", current_odr);
         JAddNumberToObject(body, "duration_ms", logging_duration);
-        JAddNumberToObject(body, "timestamp", utcTimestamp); // Using UTC timestamp
     }
+    JAddNumberToObject(body, "timestamp", timestamp); // Using UTC timestamp
+    if (activeCaptureMode == CAPTURE_MODE_FIFO) {
+        JAddNumberToObject(body, "drains", fifoDrains);
+        JAddNumberToObject(body, "awake_ms", captureAwakeMs);
+    }
+}
+
+bool DataMode::getCaptureSections(CaptureSections* sections) {
+    int count = getCollectedSamples();
+    PayloadSource src = getPayloadSource();
 
-    bool success = notecard->sendRequest(req);
+    memset(sections, 0, sizeof(*sections));
+    sections->encoder = selectPayloadEncoder(src);
+    if (count == 0 || sections->encoder == nullptr) {
+        return false;
+    }
 
-    if (success) {
+    sections->samples = count;
+    sections->dataBytes = sections->encoder->encodedSize(src, 0, count);
+    if (hasSampleTimestamps()) {
+        sections->tsBytes = count * 2;
+    }
+    if (!waveformActive) {
+        sections->extRecords = packExternalSamples(nullptr, 0, count);
+        sections->extBytes = sections->extRecords * EXT_RECORD_BYTES;
+    }
+    return true;
+}
+
+void DataMode::writeCaptureSections(const CaptureSections& sections, ByteSink& out) {
+    PayloadSource src = getPayloadSource();
+
+    sections.encoder->encode(src, 0, sections.samples, out);
+    if (sections.tsBytes > 0) {
+        out.write(tickDeltas, sections.tsBytes);
+    }
+    if (sections.extRecords > 0) {
+        packExternalSamples(&out, 0, sections.samples);
+    }
+}
+
+void DataMode::addTickInfo(J* body) {
+    JAddNumberToObject(body, "ts0", firstTick);
+    JAddNumberToObject(body, "ts_lsb_us", tickResolutionUs);
+}
+
+bool DataMode::addSampleTimestamps(J* body, B64Stream& ts, int first, int count) {
+    // "ts": base64 uint16 tick deltas per sample (the capture's first is 0),
+    // "ts0": tick of the capture's first sample, "ts_lsb_us": tick length in microseconds
+    if (!ts.begin(count * 2)) {
+        return false;
+    }
+    ts.write(&tickDeltas[first], count * 2);
+    if (!ts.addTo(body, "ts")) {
+        return false;
+    }
+    addTickInfo(body);
+    return true;
+}
+
+bool DataMode::addExternalSamples(J* body, B64Stream& ext, int first, int count) {
+    // "ext": base64 records of EXT_RECORD_BYTES for the sensor hub readings that
+    // follow this chunk's samples: slave, capture sample index (uint16), raw bytes
+    int records = packExternalSamples(nullptr, first, count);
+    if (records == 0) {
+        return true;
+    }
+
+    if (!ext.begin(records * EXT_RECORD_BYTES)) {
+        return false;
+    }
+    packExternalSamples(&ext, first, count);
+    if (!ext.addTo(body, "ext")) {
+        return false;
+    }
+    JAddNumberToObject(body, "ext_n", records);
+    return true;
+}
+
+int DataMode::packExternalSamples(ByteSink* out, int first, int count) {
+    int records = 0;
+    for (int i = 0; i < ext_samples; i++) {
+        const ExtSample& sample = extSamples[i];
+        if (sample.at < first || sample.at >= first + count) {
+            continue;
+        }
+        if (out != nullptr) {
+            out->write(&sample.slave, 1);
+            out->write(&sample.at, 2);
+            out->write(sample.data, sizeof(sample.data));
+        }
+        records++;
+    }
+    return records;
+}
+
+PayloadSource DataMode::getPayloadSource() {
+    PayloadSource src;
+    memset(&src, 0, sizeof(src));
+
+    if (storage == STORAGE_RAW_6AXIS) {
+        src.axes = 6;
+        for (int axis = 0; axis < 6; axis++) {
+            src.raw[axis] = samples.raw6[axis];
+        }
+    } else if (storage == STORAGE_RAW_INT16) {
+        src.axes = 3;
+        for (int axis = 0; axis < 3; axis++) {
+            src.raw[axis] = samples.raw[axis];
+        }
     } else {
+        src.axes = 3;
+        src.mg[0] = samples.mg.ax;
+        src.mg[1] = samples.mg.ay;
+        src.mg[2] = samples.mg.az;
     }
+    return src;
+}
+
+const PayloadEncoder* DataMode::selectPayloadEncoder(const PayloadSource& src) {
+    // An explicit choice wins over the profile's; either falls back if it cannot carry the storage
+    uint8_t format = payloadFormat != PAYLOAD_FORMAT_AUTO ? payloadFormat : captureProfiles[profile].payloadFormat;
+    return payloads.select(format, src);
+}
+
+int DataMode::getPayloadFormat() {
+    const PayloadEncoder* encoder = selectPayloadEncoder(getPayloadSource());
+    return encoder != nullptr ? encoder->format() : PAYLOAD_FORMAT_AUTO;
+}
+
+void DataMode::setPayloadFormat(uint8_t format) {
+    payloadFormat = format;
+}
 
-    // Clean up
-    free(all_data);
-    free(encoded);
+PayloadRegistry& DataMode::getPayloadEncoders() {
+    return payloads;
+}
+
+int DataMode::getSampleBytes() {
+    // RAM per sample for the next capture: 3 axes of int16 or float32, or 6 axes of int16
+    return storageSetting == STORAGE_RAW_INT16 ? 6 : 12;
 }
 
 void DataMode::setModePointer(int* modePtr) {
@@ -260,19 +916,285 @@ void DataMode::setUTCTimestamp(unsigned long timestamp) {
     utcTimestamp = timestamp;
 }
 
+void DataMode::setCaptureMode(CaptureMode mode) {
+    captureMode = mode;
+}
+
+CaptureMode DataMode::getCaptureMode() {
+    return isLogging ? activeCaptureMode : captureMode;
+}
+
+void DataMode::setFifoInterruptPin(LSM6DSOX_SensorIntPin_t pin) {
+    fifoIntPin = pin;
+    fifoIntEnabled = true;
+}
+
+void DataMode::setFifoCompression(uint8_t compression) {
+    fifoCompression = compression;
+}
+
+uint8_t DataMode::getFifoCompression() {
+    return fifoCompression;
+}
+
+void DataMode::setFifoTimestamps(bool enable) {
+    fifoTimestamps = enable;
+}
+
+bool DataMode::hasSampleTimestamps() {
+    return captureTimestamps && activeCaptureMode == CAPTURE_MODE_FIFO && !waveformActive && collected_samples > 0;
+}
+
+unsigned long DataMode::getFifoDrainCount() {
+    return fifoDrains;
+}
+
+unsigned long DataMode::getCaptureAwakeMs() {
+    return captureAwakeMs;
+}
+
+unsigned long DataMode::getDrainIntervalMs() {
+    // Sleep until either a full watermark batch or the rest of the window is queued
+    int pending = targetSamples - collected_samples;
+    if (pending > FIFO_WATERMARK_WORDS) {
+        pending = FIFO_WATERMARK_WORDS;
+    }
+    if (pending < 1) {
+        pending = 1;
+    }
+
+    return (unsigned long)(pending * 1000.0f / current_odr);
+}
+
+void DataMode::setSampleStorage(SampleStorage mode) {
+    // The live format stays with the samples already held until startLogging()
+    storageSetting = mode;
+}
+
+SampleStorage DataMode::getSampleStorage() {
+    return storageSetting;
+}
+
+int DataMode::getSampleCapacity() {
+    if (storage == STORAGE_RAW_6AXIS) {
+        return MAX_6AXIS_SAMPLES;
+    }
+    return storage == STORAGE_RAW_INT16 ? MAX_RAW_SAMPLES : MAX_SAMPLES;
+}
+
+bool DataMode::setPreTriggerWindow(float odr, unsigned long preMs, unsigned long postMs) {
+    // The FIFO is the ring, so the whole window has to fit in it
+    if (odr * (preMs + postMs) / 1000.0f > PRETRIGGER_FIFO_WORDS) {
+        return false;
+    }
+
+    ringOdr = odr;
+    ringPreMs = preMs;
+    ringPostMs = postMs;
+    return true;
+}
+
+bool DataMode::armPreTrigger() {
+    if (!accelerometerReady || isLogging) {
+        return false;
+    }
+
+    imuSnapshotClear();
+
+    // Plain XL words only: no compression or timestamps, so any suffix of the
+    // overwritten FIFO decodes on its own
+    if (AccGyr.Set_FIFO_Mode(LSM6DSOX_BYPASS_MODE) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_X_BDR(ringOdr) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_G_BDR(0.0f) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (AccGyr.Set_FIFO_Mode(LSM6DSOX_STREAM_MODE) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    AccGyr.Reset_FIFO_Decompressor();
+    ringArmed = true;
+
+    // The armed ring is the idle configuration a warm boot should come back to
+    saveImuSnapshot();
+    return true;
+}
+
+void DataMode::disarmPreTrigger() {
+    ringArmed = false;
+
+    AccGyr.Set_FIFO_X_BDR(0.0f);
+    AccGyr.Set_FIFO_Mode(LSM6DSOX_BYPASS_MODE);
+}
+
+bool DataMode::isPreTriggerArmed() {
+    return ringArmed;
+}
+
+unsigned long DataMode::getPostTriggerMs() {
+    return ringPostMs;
+}
+
+bool DataMode::capturePreTrigger(uint8_t fromState, uint8_t toState, unsigned long timestamp) {
+    if (!ringArmed) {
+        return false;
+    }
+
+    unsigned long drainStart = millis();
+
+    // The ring runs at the MLC full scale, not that of the last profile capture
+    AccGyr.Get_X_Sensitivity(&captureSensitivity);
+
+    // Freeze the ring so nothing is overwritten while it is read out
+    AccGyr.Set_FIFO_X_BDR(0.0f);
+
+    uint16_t level = 0;
+    if (AccGyr.Get_FIFO_Num_Samples(&level) != LSM6DSOX_OK) {
+        armPreTrigger();
+        return false;
+    }
+
+    // Six-axis planes need gyro words the ring does not batch
+    SampleStorage savedStorage = storage;
+    if (storage == STORAGE_RAW_6AXIS) {
+        storage = STORAGE_RAW_INT16;
+    }
+
+    int windowSamples = (int)(ringOdr * (ringPreMs + ringPostMs) / 1000.0f);
+    if (windowSamples > getSampleCapacity()) {
+        windowSamples = getSampleCapacity();
+    }
+
+    // The FIFO may hold more history than the window; drop the oldest words
+    uint16_t skip = level > windowSamples ? level - windowSamples : 0;
+
+    collected_samples = 0;
+    gyro_samples = 0;
+    fifoDrains = 1;
+
+    static uint8_t words[FIFO_DRAIN_WORDS * 7];
+
+    while (level > 0) {
+        uint16_t count = level > FIFO_DRAIN_WORDS ? FIFO_DRAIN_WORDS : level;
+
+        if (AccGyr.Get_FIFO_Sample(words, count) != LSM6DSOX_OK) {
+            break;
+        }
+        level -= count;
+
+        for (uint16_t i = 0; i < count; i++) {
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+
+            LSM6DSOX_FIFO_Decoded_t decoded;
+            if (AccGyr.Decode_FIFO_Word(&words[i * 7], &decoded) != LSM6DSOX_OK) {
+                continue;
+            }
+
+            if (decoded.Sensor == LSM6DSOX_FIFO_SENSOR_XL && collected_samples < windowSamples) {
+                storeSample(decoded.Data[0]);
+            }
+        }
+    }
+
+    captureAwakeMs = millis() - drainStart;
+
+    // The post window was slept through after the wake, so the trigger sits that far from the end
+    int postSamples = (int)(ringOdr * ringPostMs / 1000.0f);
+    triggerIndex = collected_samples > postSamples ? collected_samples - postSamples : 0;
+    triggerFrom = fromState;
+    triggerTo = toState;
+
+    waveformActive = true;
+    sendSamples(timestamp);
+    waveformActive = false;
+
+    storage = savedStorage;
+    collected_samples = 0;
+
+    return armPreTrigger();
+}
+
+bool DataMode::profileFits(CaptureProfileId id) {
+    if (id >= PROFILE_COUNT) {
+        return false;
+    }
+
+    const CaptureProfile& p = captureProfiles[id];
+
+    // RAM budget: the whole window has to fit the shared sample store
+    if ((long)p.sampleBudget * getSampleBytes() > CAPTURE_BUFFER_BYTES) {
+        return false;
+    }
+
+    // Fast profiles only hold up when the sensor FIFO paces the samples
+    if (p.odr > POLLED_MAX_ODR_HZ && captureMode != CAPTURE_MODE_FIFO) {
+        return false;
+    }
+
+    return true;
+}
+
+bool DataMode::setCaptureProfile(CaptureProfileId id) {
+    if (!profileFits(id)) {
+        return false;
+    }
+
+    const CaptureProfile& p = captureProfiles[id];
+    profile = id;
+    current_odr = p.odr;
+    current_fs = p.fullScale;
+    logging_duration = p.durationMs;
+    sampleBudget = p.sampleBudget;
+    sample_interval_ms = (unsigned long)(1000.0f / current_odr);
+    return true;
+}
+
+CaptureProfileId DataMode::getCaptureProfile() {
+    return profile;
+}
+
 float* DataMode::getAxSamples() {
-    return ax_samples;
+    return samples.mg.ax;
 }
 
 float* DataMode::getAySamples() {
-    return ay_samples;
+    return samples.mg.ay;
 }
 
 float* DataMode::getAzSamples() {
-    return az_samples;
+    return samples.mg.az;
+}
+
+int16_t* DataMode::getRawSamples(int axis) {
+    if (storage == STORAGE_RAW_6AXIS) {
+        return samples.raw6[axis];
+    }
+    return samples.raw[axis];
+}
+
+float DataMode::getSampleScale() {
+    return captureSensitivity;
+}
+
+float DataMode::getGyroScale() {
+    return gyroSensitivity;
 }
 
 int DataMode::getCollectedSamples() {
+    // Only complete accel+gyro pairs are reported in six-axis captures
+    if (storage == STORAGE_RAW_6AXIS && gyro_samples < collected_samples) {
+        return gyro_samples;
+    }
     return collected_samples;
 }
 
@@ -284,6 +1206,18 @@ unsigned long DataMode::getLoggingDuration() {
     return logging_duration;
 }
 
+const UcfLoadReport& DataMode::getMlcLoadReport() {
+    return mlcLoad;
+}
+
+MlcModelManager& DataMode::getMlcModels() {
+    return mlcModels;
+}
+
+ImuEventDispatcher& DataMode::getImuEvents() {
+    return imuEvents;
+}
+
 uint8_t DataMode::getCurrentMlcState() {
     if (accelerometer == nullptr) {
         return 0;
@@ -294,4 +1228,102 @@ uint8_t DataMode::getCurrentMlcState() {
         return mlc_out[0]; // Return first MLC output
     }
     return 0;
-}
\ No newline at end of file
+}
+
+bool DataMode::requestMlcEvent(uint8_t status, uint32_t epoch, uint16_t epochMs) {
+    if (accelerometer == nullptr || asyncSensor == nullptr || mlcEventRequested) {
+        return false;
+    }
+
+    // Embedded bank for MLC0_SRC..MLC7_SRC, then back to the user bank for the
+    // timestamp; four queued transactions started back to back from the interrupts
+    static const uint8_t embeddedBank = (uint8_t)(LSM6DSOX_EMBEDDED_FUNC_BANK << 6);
+    static const uint8_t userBank = (uint8_t)(LSM6DSOX_USER_BANK << 6);
+
+    memset(&mlcEvent, 0, sizeof(mlcEvent));
+    mlcEvent.status = status;
+    mlcEvent.epoch = epoch;
+    mlcEvent.epochMs = epochMs;
+
+    // The queue holds all four, so only the first enqueue can fail
+    if (!asyncSensor->write(LSM6DSOX_FUNC_CFG_ACCESS, &embeddedBank, 1, nullptr, nullptr)) {
+        return false;
+    }
+    asyncSensor->read(LSM6DSOX_MLC0_SRC, mlcEvent.outputs, sizeof(mlcEvent.outputs), &mlcEventOutputs);
+    asyncSensor->write(LSM6DSOX_FUNC_CFG_ACCESS, &userBank, 1, nullptr, nullptr);
+    asyncSensor->read(LSM6DSOX_TIMESTAMP0, mlcEventTicks, sizeof(mlcEventTicks), &mlcEventTimestamp);
+
+    mlcEventRequested = true;
+    return true;
+}
+
+bool DataMode::mlcEventReady() {
+    return mlcEventRequested && asyncSensor->isIdle();
+}
+
+bool DataMode::takeMlcEvent(MlcEvent* event) {
+    if (!mlcEventRequested) {
+        memset(event, 0, sizeof(*event));
+        event->valid = accelerometer != nullptr &&
+                       accelerometer->Get_MLC_Output(event->outputs) == LSM6DSOX_OK;
+        return event->valid;
+    }
+
+    asyncSensor->waitIdle();
+    mlcEventRequested = false;
+
+    mlcEvent.valid = mlcEventOutputs.done && mlcEventOutputs.status == LSM6DSOX_OK;
+    if (mlcEvent.valid && mlcEventTimestamp.done && mlcEventTimestamp.status == LSM6DSOX_OK) {
+        mlcEvent.sensorTicks = (uint32_t)mlcEventTicks[0] | ((uint32_t)mlcEventTicks[1] << 8) |
+                               ((uint32_t)mlcEventTicks[2] << 16) | ((uint32_t)mlcEventTicks[3] << 24);
+    }
+
+    *event = mlcEvent;
+    return mlcEvent.valid;
+}
+
+bool DataMode::writeExternalSensor(uint8_t address, uint8_t reg, uint8_t value) {
+    if (!accelerometerReady || isLogging) {
+        return false;
+    }
+
+    if (AccGyr.Sensor_Hub_Write(address, reg, value) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    // The write goes out on slave 0, so put its read back
+    if (extSlaves > 0) {
+        const ExtSensorConfig& cfg = extSensors[0];
+        return AccGyr.Sensor_Hub_Config_Slave(0, cfg.address, cfg.reg, cfg.len) == LSM6DSOX_OK;
+    }
+    return true;
+}
+
+bool DataMode::attachExternalSensor(uint8_t address, uint8_t reg, uint8_t len) {
+    // A FIFO word carries 6 data bytes, so longer reads would not be batched whole
+    if (!accelerometerReady || isLogging || extSlaves >= LSM6DSOX_SH_MAX_SLAVES || len == 0 || len > 6) {
+        return false;
+    }
+
+    // Boards without sensor hub slaves never pay for the reading store
+    if (extSamples == nullptr) {
+        extSamples = (ExtSample*)malloc(MAX_EXT_SAMPLES * sizeof(ExtSample));
+        if (extSamples == nullptr) {
+            return false;
+        }
+    }
+
+    if (AccGyr.Sensor_Hub_Config_Slave(extSlaves, address, reg, len) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    extSensors[extSlaves].address = address;
+    extSensors[extSlaves].reg = reg;
+    extSensors[extSlaves].len = len;
+    extSlaves++;
+    return true;
+}
+
+int DataMode::getExternalSampleCount() {
+    return ext_samples;
+}
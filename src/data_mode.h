@@ -5,9 +5,129 @@
 #include <Wire.h>
 #include <Notecard.h>
 #include "LSM6DSOXSensor.h"
+#include "ucf_loader.h"
+#include "mlc_models.h"
+#include "lsm6dsox_async.h"
+#include "imu_snapshot.h"
+#include "imu_events.h"
+#include "b64_stream.h"
+#include "payload_encoder.h"
+#include "sync_policy.h"
 
-// Data storage for batching (same as previous example)
-#define MAX_SAMPLES 300
+// Models registered with the MLC model manager, in registration order
+enum MlcModelId {
+    MLC_MODEL_ONOFF = 0,     // boot default
+    MLC_MODEL_MOVEMENT = 1
+};
+
+// MLC change latched at interrupt time, before anything slow runs
+struct MlcEvent {
+    uint8_t status;         // MLC_STATUS_MAINPAGE: bit n set when tree n+1 changed, 0 if the bit had dropped
+    uint8_t outputs[8];     // MLC0_SRC..MLC7_SRC
+    uint32_t sensorTicks;   // TIMESTAMP0..3 at the read, in sensor ticks (~25 us); 0 if not read back
+    uint32_t epoch;         // RTC time of the wake
+    uint16_t epochMs;
+    bool valid;             // outputs were read back
+};
+
+// Data storage for batching. One byte budget is shared by every storage format,
+// sized for the 1.66 kHz burst profile (3332 int16 samples x 6 bytes)
+#define CAPTURE_BUFFER_BYTES (20 * 1024)
+#define MAX_SAMPLES (CAPTURE_BUFFER_BYTES / 12)
+
+// FIFO capture tuning. Without DMA each burst is one blocking Wire transaction
+// (at most 36 words); with LSM6DSOX_I2C_DMA one burst drains a whole watermark batch
+#if defined(LSM6DSOX_I2C_DMA)
+#define FIFO_DRAIN_WORDS 128
+#else
+#define FIFO_DRAIN_WORDS 32
+#endif
+#define FIFO_WATERMARK_WORDS 64
+
+// Raw int16 samples take half the RAM of floats, so the same store holds twice as many
+#define MAX_RAW_SAMPLES (CAPTURE_BUFFER_BYTES / 6)
+
+// Six-axis captures keep accel and gyro counts in the same store
+#define MAX_6AXIS_SAMPLES (CAPTURE_BUFFER_BYTES / 12)
+
+// Above this rate millis() pacing cannot keep up, so profiles need FIFO capture
+#define POLLED_MAX_ODR_HZ 104.0f
+
+// Samples per sensors.qo note; larger captures are split into numbered chunks
+#define UPLOAD_CHUNK_SAMPLES 512
+
+// Gyro full scale used for six-axis captures
+#define GYRO_CAPTURE_FS_DPS 500
+
+// Sample time offsets are uploaded as uint16 tick deltas; gaps that do not fit
+// (or samples without a batched timestamp) are marked with this value
+#define TICK_DELTA_UNKNOWN 0xFFFF
+
+// External I2C sensors read by the LSM6DSOX sensor hub and batched into the same
+// FIFO; each reading is uploaded with the index of the accel sample it follows
+#define MAX_EXT_SAMPLES 256
+#define EXT_RECORD_BYTES 9  // uint8 slave, uint16 sample index, 6 raw bytes
+
+struct ExtSensorConfig {
+    uint8_t address;  // 7-bit I2C address
+    uint8_t reg;      // first register read every sensor hub cycle
+    uint8_t len;      // bytes read, 1 to 6
+};
+
+// Layout of a whole capture on the card.binary upload path: the encoded samples,
+// then the uint16 tick deltas, then the sensor hub records, back to back
+struct CaptureSections {
+    const PayloadEncoder* encoder;
+    int samples;
+    int dataBytes;
+    int tsBytes;      // 0 without batched timestamps
+    int extBytes;
+    int extRecords;
+};
+
+struct ExtSample {
+    uint8_t slave;
+    uint16_t at;      // collected_samples when the word was drained
+    uint8_t data[6];
+};
+
+// How samples are kept in RAM during a capture window
+enum SampleStorage {
+    STORAGE_FLOAT32 = 0,   // mg values as float, 12 bytes per sample
+    STORAGE_RAW_INT16 = 1,  // raw Get_X_AxesRaw counts plus one scale per capture, 6 bytes per sample
+    STORAGE_RAW_6AXIS = 2   // raw accel and gyro counts, 12 bytes per sample
+};
+
+// Pre-trigger ring: between captures the sensor FIFO runs in continuous mode at a
+// low batch rate, overwriting its oldest words, so it always holds the recent past
+#define PRETRIGGER_ODR_HZ 12.5f
+#define PRETRIGGER_PRE_MS 28000
+#define PRETRIGGER_POST_MS 10000
+// The ring runs uncompressed, so only the 3 KB raw FIFO (512 words) is available;
+// the margin keeps the oldest pre-trigger words from being overwritten
+#define PRETRIGGER_FIFO_WORDS 480
+
+// Capture profiles: ODR, full scale, window length and sample budget
+enum CaptureProfileId {
+    PROFILE_MLC_26HZ = 0,       // 26 Hz, 2 g, 10 s: the MLC operating point
+    PROFILE_VIBRATION_416HZ,    // 416 Hz, 4 g, 5 s
+    PROFILE_BURST_1666HZ,       // 1.66 kHz, 8 g, 2 s, FIFO only
+    PROFILE_COUNT
+};
+
+struct CaptureProfile {
+    float odr;                    // Hz
+    int32_t fullScale;            // g
+    unsigned long durationMs;
+    int sampleBudget;             // samples kept per axis
+    uint8_t payloadFormat;        // sensors.qo wire format, PAYLOAD_FORMAT_AUTO for the storage default
+};
+
+// How samples are acquired during a capture window
+enum CaptureMode {
+    CAPTURE_MODE_POLLED = 0,  // one Get_X_Axes() transaction per sample, paced by millis()
+    CAPTURE_MODE_FIFO = 1     // sensor FIFO batches samples, MCU drains them in bursts
+};
 
 class DataMode {
 private:
@@ -21,12 +141,68 @@ private:
     float current_odr;
     unsigned long sample_interval_ms;
     unsigned long logging_duration;
+    int32_t current_fs;
+    int sampleBudget;
+    CaptureProfileId profile;
+
+    // FIFO capture state. captureMode is the configured mode; activeCaptureMode is
+    // what the running (or last) capture uses, polled if the FIFO could not be set up
+    CaptureMode captureMode;
+    CaptureMode activeCaptureMode;
+    float captureSensitivity;
+    float gyroSensitivity;
+    int targetSamples;
+    bool fifoIntEnabled;
+    LSM6DSOX_SensorIntPin_t fifoIntPin;
+    uint8_t fifoCompression;
+
+    // Per-sample hardware timestamps batched into the FIFO. fifoTimestamps is the
+    // setting; captureTimestamps whether the running (or last) capture has them.
+    // tickDeltas is allocated by the first capture that batches timestamps.
+    bool fifoTimestamps;
+    bool captureTimestamps;
+    float tickResolutionUs;
+    uint32_t firstTick;
+    uint32_t lastTick;
+    uint16_t* tickDeltas;  // MAX_RAW_SAMPLES ticks since the previous sample, TICK_DELTA_UNKNOWN if missing
+
+    // Sensor hub slaves and the readings they batched during the capture;
+    // the reading store is allocated by the first attachExternalSensor()
+    ExtSensorConfig extSensors[LSM6DSOX_SH_MAX_SLAVES];
+    uint8_t extSlaves;
+    ExtSample* extSamples;
+    int ext_samples;
+
+    // Pre-trigger ring configuration and the waveform being uploaded
+    float ringOdr;
+    unsigned long ringPreMs;
+    unsigned long ringPostMs;
+    bool ringArmed;
+    bool waveformActive;
+    int triggerIndex;
+    uint8_t triggerFrom;
+    uint8_t triggerTo;
 
-    // Data storage arrays
-    float ax_samples[MAX_SAMPLES];
-    float ay_samples[MAX_SAMPLES];
-    float az_samples[MAX_SAMPLES];
+    // Duty-cycle statistics for the last capture
+    unsigned long fifoDrains;
+    unsigned long captureAwakeMs;
+
+    // Data storage arrays, shared by both storage formats. storageSetting is the
+    // configured format; storage is the running (or last) capture's, which drops
+    // to raw int16 if the gyro could not be started
+    SampleStorage storageSetting;
+    SampleStorage storage;
+    union {
+        struct {
+            float ax[MAX_SAMPLES];
+            float ay[MAX_SAMPLES];
+            float az[MAX_SAMPLES];
+        } mg;
+        int16_t raw[3][MAX_RAW_SAMPLES];  // planar x, y, z blocks
+        int16_t raw6[6][MAX_6AXIS_SAMPLES];  // planar ax, ay, az, gx, gy, gz blocks
+    } samples;
     int collected_samples;
+    int gyro_samples;  // gyro fill level in STORAGE_RAW_6AXIS, paired with accel by index
 
     // External notecard reference
     Notecard* notecard;
@@ -40,6 +216,34 @@ private:
     // MLC-enabled accelerometer
     LSM6DSOXSensor* accelerometer;
 
+    // MLC programs and how the active one got loaded at boot
+    MlcModelManager mlcModels;
+    UcfLoadReport mlcLoad;
+    bool mlcLoadPending;
+
+    // Warm-boot restore from the register snapshot, reported with mlcLoad
+    ImuRestoreReport imuRestore;
+
+    // Interrupt-driven MLC event latch, overlapped with the wake blink
+    LSM6DSOXAsync* asyncSensor;
+    MlcEvent mlcEvent;
+    uint8_t mlcEventTicks[4];
+    LSM6DSOXFuture mlcEventOutputs;
+    LSM6DSOXFuture mlcEventTimestamp;
+    bool mlcEventRequested;
+
+    // Interrupt source attribution for pin wakes
+    ImuEventDispatcher imuEvents;
+
+    // sensors.qo wire formats and the explicit choice, PAYLOAD_FORMAT_AUTO for the profile's
+    PayloadRegistry payloads;
+    uint8_t payloadFormat;
+    unsigned long uploadBytes;     // base64 characters in the last sendSamples()
+    unsigned long uploadRawBytes;  // payload bytes those characters encode
+
+    // Decides when queued sensors.qo notes sync; without one every note syncs
+    SyncPolicy* syncPolicy;
+
 public:
     DataMode();
 
@@ -52,23 +256,124 @@ public:
     void setModePointer(int* modePtr);
     void setUTCTimestamp(unsigned long timestamp);
 
-    // Methods to get collected data for sending
+    // Capture mode selection (takes effect on the next startLogging)
+    // getCaptureMode() reports the running capture's mode while logging
+    void setCaptureMode(CaptureMode mode);
+    CaptureMode getCaptureMode();
+    unsigned long getDrainIntervalMs();
+
+    // Route the FIFO watermark to an INT pin so the MCU can sleep until a batch is ready
+    void setFifoInterruptPin(LSM6DSOX_SensorIntPin_t pin);
+    unsigned long getFifoDrainCount();
+    unsigned long getCaptureAwakeMs();
+
+    // In-sensor FIFO compression (LSM6DSOX_CMP_DISABLE, _8_TO_1, _16_TO_1 or _32_TO_1)
+    void setFifoCompression(uint8_t compression);
+    uint8_t getFifoCompression();
+
+    // Batch the sensor timestamp counter into the FIFO (FIFO capture mode only)
+    void setFifoTimestamps(bool enable);
+    bool hasSampleTimestamps();
+    bool addSampleTimestamps(J* body, B64Stream& ts, int first, int count);
+
+    // External I2C sensors on the sensor hub, batched during FIFO captures.
+    // Each attach takes the next slave; writeExternalSensor() programs a sensor
+    // through the hub (e.g. to start a magnetometer) and can be used at any time
+    bool writeExternalSensor(uint8_t address, uint8_t reg, uint8_t value);
+    bool attachExternalSensor(uint8_t address, uint8_t reg, uint8_t len);
+    int getExternalSampleCount();
+    bool addExternalSamples(J* body, B64Stream& ext, int first, int count);
+    int packExternalSamples(ByteSink* out, int first, int count);
+
+    // Sample storage selection (takes effect on the next startLogging; samples
+    // already held, and their upload, keep the format they were captured in).
+    // getSampleCapacity() is the running capture's.
+    void setSampleStorage(SampleStorage mode);
+    SampleStorage getSampleStorage();
+    int getSampleCapacity();
+
+    // Pre-trigger ring for MLC state-change waveforms. Arm between captures;
+    // after a D6 transition sleep getPostTriggerMs(), then capture the waveform
+    bool setPreTriggerWindow(float odr, unsigned long preMs, unsigned long postMs);
+    bool armPreTrigger();
+    void disarmPreTrigger();
+    bool isPreTriggerArmed();
+    unsigned long getPostTriggerMs();
+    bool capturePreTrigger(uint8_t fromState, uint8_t toState, unsigned long timestamp);
+
+    // Capture profile selection; fails if the profile does not fit the RAM
+    // budget or needs FIFO capture, so select mode and storage first
+    bool setCaptureProfile(CaptureProfileId id);
+    CaptureProfileId getCaptureProfile();
+    bool profileFits(CaptureProfileId id);
+
+    // Methods to get collected data for sending (float arrays in STORAGE_FLOAT32 only)
     float* getAxSamples();
     float* getAySamples();
     float* getAzSamples();
+    int16_t* getRawSamples(int axis);
+    float getSampleScale();
+    float getGyroScale();
     int getCollectedSamples();
+
+    // Packed sensors.qo payload for the collected samples; sendSamples() is false
+    // if any note could not be built or sent. setPayloadFormat() overrides the
+    // capture profile's format; formats that cannot carry the storage fall back.
+    // begin() registers the built-in encoders; add custom ones after it
+    int getPayloadFormat();
+    void setPayloadFormat(uint8_t format);
+    PayloadRegistry& getPayloadEncoders();
+    int getSampleBytes();
+    bool sendSamples(unsigned long timestamp);
+    void setSyncPolicy(SyncPolicy* policy);
+    unsigned long getLastUploadBytes();
+    unsigned long getLastUploadRawBytes();
+
+    // The whole capture as one binary blob for CollectMode's card.binary path,
+    // plus the note fields shared with sensors.qo
+    bool getCaptureSections(CaptureSections* sections);
+    void writeCaptureSections(const CaptureSections& sections, ByteSink& out);
+    void addCaptureInfo(J* body, unsigned long timestamp);
+    void addTickInfo(J* body);
     float getCurrentODR();
     unsigned long getLoggingDuration();
 
     // MLC state reading
     uint8_t getCurrentMlcState();
 
+    // Latch an MLC change: queues MLC0..7_SRC and the sensor timestamp right away
+    // and stamps the RTC time given by the caller. takeMlcEvent() waits for the bus;
+    // without a queued request it falls back to a blocking output read.
+    bool requestMlcEvent(uint8_t status, uint32_t epoch, uint16_t epochMs);
+    bool mlcEventReady();
+    bool takeMlcEvent(MlcEvent* event);
+    const UcfLoadReport& getMlcLoadReport();
+    MlcModelManager& getMlcModels();
+    ImuEventDispatcher& getImuEvents();
+
 private:
     bool initializeAccelerometer();
+    bool resumeAccelerometer();
+    void saveImuSnapshot();
     void readAndPrintAcceleration();
     void logAccelerationData();
+    bool startFifoCapture();
+    void stopFifoCapture();
+    LSM6DSOXStatusTypeDef setFifoThresholdRoute(uint8_t enable);
+    void drainFifo();
+    void storeSample(const int16_t* raw);
+    void storeGyroSample(const int16_t* raw);
+    bool captureFull();
+    bool startGyroCapture();
+    bool startExternalCapture();
+    void stopExternalCapture();
+    void storeExtSample(const LSM6DSOX_FIFO_Decoded_t& decoded);
+    void storeTick(uint32_t tick, bool valid);
+    bool applyCaptureConfig(float odr, int32_t fullScale);
     void sendSamplesToCloud();
-    void writeBinaryData();
+    PayloadSource getPayloadSource();
+    const PayloadEncoder* selectPayloadEncoder(const PayloadSource& src);
+    bool writeBinaryData(unsigned long timestamp, int first, int count, int chunk, int chunks);
 };
 
 #endif // DATA_MODE_H
\ No newline at end of file
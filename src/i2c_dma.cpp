@@ -0,0 +1,230 @@
+#include "i2c_dma.h"
+
+#if defined(LSM6DSOX_I2C_DMA)
+
+// I2C1_RX request on DMA1 channel 7 (STM32L43x reference manual, table 41)
+static DMA_HandleTypeDef dmaRx;
+static I2C_HandleTypeDef* dmaI2c = nullptr;
+
+// Transfer in flight
+static volatile bool dmaBusy = false;
+static volatile bool dmaOk = false;
+static I2cDmaCallback dmaDone = nullptr;
+static void* dmaContext = nullptr;
+static uint8_t dmaAddr = 0;
+static uint32_t dmaStart = 0;
+
+static void finishTransfer(bool ok) {
+    dmaOk = ok;
+    dmaBusy = false;
+
+    I2cDmaCallback done = dmaDone;
+    dmaDone = nullptr;
+    if (done != nullptr) {
+        done(ok, dmaContext);
+    }
+}
+
+extern "C" void DMA1_Channel7_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&dmaRx);
+}
+
+// The core's twi driver only implements the slave and error callbacks, so the
+// memory-read and memory-write completions are free for us
+extern "C" void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == dmaI2c && dmaBusy) {
+        finishTransfer(true);
+    }
+}
+
+extern "C" void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == dmaI2c && dmaBusy) {
+        finishTransfer(true);
+    }
+}
+
+bool i2cDmaBegin(TwoWire* wire) {
+    i2c_t* obj = wire->getHandle();
+    if (obj == nullptr || obj->i2c != I2C1) {
+        return false;
+    }
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    dmaRx.Instance = DMA1_Channel7;
+    dmaRx.Init.Request = DMA_REQUEST_3;
+    dmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    dmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+    dmaRx.Init.MemInc = DMA_MINC_ENABLE;
+    dmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    dmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    dmaRx.Init.Mode = DMA_NORMAL;
+    dmaRx.Init.Priority = DMA_PRIORITY_LOW;
+
+    if (HAL_DMA_Init(&dmaRx) != HAL_OK) {
+        return false;
+    }
+
+    __HAL_LINKDMA(&obj->handle, hdmarx, dmaRx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+
+    dmaI2c = &obj->handle;
+    return true;
+}
+
+bool i2cDmaAvailable() {
+    return dmaI2c != nullptr;
+}
+
+bool i2cDmaBusy() {
+    return dmaBusy;
+}
+
+bool i2cDmaReadStart(uint8_t addr7, uint8_t reg, uint8_t* buf, uint16_t len,
+                     I2cDmaCallback done, void* context) {
+    if (dmaI2c == nullptr || dmaBusy || len == 0) {
+        return false;
+    }
+
+    if (HAL_I2C_GetState(dmaI2c) != HAL_I2C_STATE_READY) {
+        return false;
+    }
+
+    dmaDone = done;
+    dmaContext = context;
+    dmaAddr = addr7;
+    dmaStart = millis();
+    dmaOk = false;
+    dmaBusy = true;
+
+    // Short reads are cheaper interrupt-driven than setting up the DMA channel
+    HAL_StatusTypeDef status = (len >= I2C_DMA_MIN_BYTES)
+        ? HAL_I2C_Mem_Read_DMA(dmaI2c, (uint16_t)(addr7 << 1), reg, I2C_MEMADD_SIZE_8BIT, buf, len)
+        : HAL_I2C_Mem_Read_IT(dmaI2c, (uint16_t)(addr7 << 1), reg, I2C_MEMADD_SIZE_8BIT, buf, len);
+
+    if (status != HAL_OK) {
+        dmaBusy = false;
+        dmaDone = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool i2cDmaWriteStart(uint8_t addr7, uint8_t reg, const uint8_t* buf, uint16_t len,
+                      I2cDmaCallback done, void* context) {
+    if (dmaI2c == nullptr || dmaBusy || len == 0) {
+        return false;
+    }
+
+    if (HAL_I2C_GetState(dmaI2c) != HAL_I2C_STATE_READY) {
+        return false;
+    }
+
+    dmaDone = done;
+    dmaContext = context;
+    dmaAddr = addr7;
+    dmaStart = millis();
+    dmaOk = false;
+    dmaBusy = true;
+
+    // Register writes are short, so no TX DMA channel is needed
+    if (HAL_I2C_Mem_Write_IT(dmaI2c, (uint16_t)(addr7 << 1), reg, I2C_MEMADD_SIZE_8BIT,
+                             (uint8_t*)buf, len) != HAL_OK) {
+        dmaBusy = false;
+        dmaDone = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool i2cDmaPoll() {
+    if (!dmaBusy) {
+        return dmaOk;
+    }
+
+    // Bus errors end in the core's error callback, which leaves the handle
+    // READY with an error code set
+    bool failed = HAL_I2C_GetState(dmaI2c) == HAL_I2C_STATE_READY &&
+                  HAL_I2C_GetError(dmaI2c) != HAL_I2C_ERROR_NONE;
+
+    if (!failed && millis() - dmaStart > I2C_DMA_TIMEOUT_MS) {
+        HAL_I2C_Master_Abort_IT(dmaI2c, (uint16_t)(dmaAddr << 1));
+        failed = true;
+    }
+
+    if (failed) {
+        noInterrupts();
+        if (dmaBusy) {
+            finishTransfer(false);
+        }
+        interrupts();
+        return false;
+    }
+
+    return true;
+}
+
+void i2cDmaWaitIdle() {
+    while (dmaBusy) {
+        i2cDmaPoll();
+        if (dmaBusy) {
+            __WFI();
+        }
+    }
+}
+
+bool i2cDmaRead(uint8_t addr7, uint8_t reg, uint8_t* buf, uint16_t len) {
+    if (!i2cDmaReadStart(addr7, reg, buf, len, nullptr, nullptr)) {
+        return false;
+    }
+
+    while (dmaBusy) {
+        if (!i2cDmaPoll()) {
+            return false;
+        }
+
+        // DMA, I2C and SysTick interrupts all wake the core again
+        __WFI();
+    }
+
+    return dmaOk;
+}
+
+#else
+
+bool i2cDmaBegin(TwoWire*) {
+    return false;
+}
+
+bool i2cDmaAvailable() {
+    return false;
+}
+
+bool i2cDmaBusy() {
+    return false;
+}
+
+bool i2cDmaReadStart(uint8_t, uint8_t, uint8_t*, uint16_t, I2cDmaCallback, void*) {
+    return false;
+}
+
+bool i2cDmaWriteStart(uint8_t, uint8_t, const uint8_t*, uint16_t, I2cDmaCallback, void*) {
+    return false;
+}
+
+bool i2cDmaPoll() {
+    return false;
+}
+
+void i2cDmaWaitIdle() {
+}
+
+bool i2cDmaRead(uint8_t, uint8_t, uint8_t*, uint16_t) {
+    return false;
+}
+
+#endif // LSM6DSOX_I2C_DMA
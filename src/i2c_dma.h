@@ -0,0 +1,47 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// DMA-backed I2C register reads for bulk transfers such as FIFO drains.
+// Opt in with -D LSM6DSOX_I2C_DMA; only I2C1 (the Cygnet Wire bus) is mapped,
+// on DMA1 channel 7. Without the flag every call reports "not available" and
+// callers fall back to blocking Wire transactions.
+
+// Reads shorter than this are cheaper as a plain Wire transaction
+#define I2C_DMA_MIN_BYTES 32
+
+// Upper bound for one blocking transfer (400 kHz moves ~40 bytes per ms)
+#define I2C_DMA_TIMEOUT_MS 100
+
+// Completion callback, called from interrupt context for async reads
+typedef void (*I2cDmaCallback)(bool ok, void* context);
+
+// Link a DMA channel to the bus; call after wire->begin()
+bool i2cDmaBegin(TwoWire* wire);
+bool i2cDmaAvailable();
+bool i2cDmaBusy();
+
+// Start a read of len bytes from register reg of 7-bit device addr7, by DMA from
+// I2C_DMA_MIN_BYTES up and interrupt-driven below. done (may be nullptr) runs
+// when the transfer completes.
+bool i2cDmaReadStart(uint8_t addr7, uint8_t reg, uint8_t* buf, uint16_t len,
+                     I2cDmaCallback done, void* context);
+
+// Start an interrupt-driven write of len bytes to register reg; buf must stay
+// valid until done runs
+bool i2cDmaWriteStart(uint8_t addr7, uint8_t reg, const uint8_t* buf, uint16_t len,
+                      I2cDmaCallback done, void* context);
+
+// Check a running transfer for bus errors and the timeout; returns false once it failed
+bool i2cDmaPoll();
+
+// Sleep (WFI) until the running transfer, and any transfer its callback
+// chained, completed or failed
+void i2cDmaWaitIdle();
+
+// Blocking read that sleeps the core (WFI) while the DMA runs
+bool i2cDmaRead(uint8_t addr7, uint8_t reg, uint8_t* buf, uint16_t len);
+
+#endif // I2C_DMA_H
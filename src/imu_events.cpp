@@ -0,0 +1,81 @@
+#include "imu_events.h"
+
+ImuEventDispatcher::ImuEventDispatcher() : sensor(nullptr) {
+    memset(handlers, 0, sizeof(handlers));
+    memset(contexts, 0, sizeof(contexts));
+    memset(&sources, 0, sizeof(sources));
+}
+
+void ImuEventDispatcher::begin(LSM6DSOXSensor* s) {
+    sensor = s;
+}
+
+void ImuEventDispatcher::on(ImuEventType type, ImuEventHandler handler, void* context) {
+    if (type >= IMU_EVENT_COUNT) {
+        return;
+    }
+
+    handlers[type] = handler;
+    contexts[type] = context;
+}
+
+void ImuEventDispatcher::dispatch(ImuEventType type, uint16_t detail) {
+    if (handlers[type] == nullptr) {
+        return;
+    }
+
+    ImuEvent event;
+    event.type = type;
+    event.detail = detail;
+    event.sources = &sources;
+    handlers[type](event, contexts[type]);
+}
+
+int ImuEventDispatcher::poll() {
+    if (sensor == nullptr || sensor->Get_All_Sources(&sources) != LSM6DSOX_OK) {
+        return -1;
+    }
+
+    int found = 0;
+
+    uint16_t mlc = (uint16_t)(sources.mlc1 | (sources.mlc2 << 1) | (sources.mlc3 << 2) |
+                              (sources.mlc4 << 3) | (sources.mlc5 << 4) | (sources.mlc6 << 5) |
+                              (sources.mlc7 << 6) | (sources.mlc8 << 7));
+    if (mlc != 0) {
+        dispatch(IMU_EVENT_MLC, mlc);
+        found++;
+    }
+
+    uint16_t fsm = (uint16_t)(sources.fsm1 | (sources.fsm2 << 1) | (sources.fsm3 << 2) |
+                              (sources.fsm4 << 3) | (sources.fsm5 << 4) | (sources.fsm6 << 5) |
+                              (sources.fsm7 << 6) | (sources.fsm8 << 7) | (sources.fsm9 << 8) |
+                              (sources.fsm10 << 9) | (sources.fsm11 << 10) | (sources.fsm12 << 11) |
+                              (sources.fsm13 << 12) | (sources.fsm14 << 13) | (sources.fsm15 << 14) |
+                              (sources.fsm16 << 15));
+    if (fsm != 0) {
+        dispatch(IMU_EVENT_FSM, fsm);
+        found++;
+    }
+
+    if (sources.wake_up) {
+        dispatch(IMU_EVENT_WAKE_UP, (uint16_t)(sources.wake_up_x | (sources.wake_up_y << 1) |
+                                               (sources.wake_up_z << 2)));
+        found++;
+    }
+
+    if (sources.single_tap || sources.double_tap) {
+        dispatch(IMU_EVENT_TAP, sources.double_tap ? 2 : 1);
+        found++;
+    }
+
+    if (sources.fifo_th) {
+        dispatch(IMU_EVENT_FIFO_WATERMARK, sources.fifo_diff);
+        found++;
+    }
+
+    return found;
+}
+
+const lsm6dsox_all_sources_t& ImuEventDispatcher::getSources() {
+    return sources;
+}
@@ -0,0 +1,54 @@
+#ifndef IMU_EVENTS_H
+#define IMU_EVENTS_H
+
+#include <Arduino.h>
+#include "LSM6DSOXSensor.h"
+
+// Wake attribution: one burst read of every LSM6DSOX interrupt source per pin
+// interrupt, dispatched as typed events to registered handlers
+
+enum ImuEventType {
+    IMU_EVENT_MLC = 0,            // an MLC decision tree changed its output
+    IMU_EVENT_WAKE_UP = 1,        // wake-up threshold crossed
+    IMU_EVENT_TAP = 2,            // single or double tap
+    IMU_EVENT_FIFO_WATERMARK = 3, // FIFO reached its threshold
+    IMU_EVENT_FSM = 4,            // an FSM program signalled
+    IMU_EVENT_COUNT
+};
+
+struct ImuEvent {
+    ImuEventType type;
+    // MLC: bit n set when tree n+1 changed. FSM: bit n set when program n+1 signalled. Wake-up: bit 0/1/2 for x/y/z.
+    // Tap: 1 single, 2 double. FIFO: unread words.
+    uint16_t detail;
+    const lsm6dsox_all_sources_t* sources;  // the whole burst, for anything else
+};
+
+typedef void (*ImuEventHandler)(const ImuEvent& event, void* context);
+
+class ImuEventDispatcher {
+private:
+    LSM6DSOXSensor* sensor;
+    ImuEventHandler handlers[IMU_EVENT_COUNT];
+    void* contexts[IMU_EVENT_COUNT];
+    lsm6dsox_all_sources_t sources;
+
+    void dispatch(ImuEventType type, uint16_t detail);
+
+public:
+    ImuEventDispatcher();
+
+    void begin(LSM6DSOXSensor* sensor);
+
+    // One handler per event type; nullptr removes it
+    void on(ImuEventType type, ImuEventHandler handler, void* context);
+
+    // Read all sources in one transaction and dispatch what is set.
+    // Returns the number of events found, or -1 on a bus error.
+    int poll();
+
+    // Sources from the last poll()
+    const lsm6dsox_all_sources_t& getSources();
+};
+
+#endif // IMU_EVENTS_H
@@ -0,0 +1,129 @@
+#include "imu_snapshot.h"
+#include <backup.h>
+
+// Header word: magic, layout version, model index
+#define SNAPSHOT_MAGIC 0x5D0Cu
+#define SNAPSHOT_VERSION 1
+
+// Header, checksums, then the register image packed four bytes per backup register
+#define SNAPSHOT_WORDS (2 + (IMU_SNAPSHOT_BYTES + 3) / 4)
+
+struct RegBlock {
+    uint8_t first;
+    uint8_t count;
+};
+
+static const RegBlock snapshotBlocks[] = {
+    { LSM6DSOX_FIFO_CTRL1, 8 },   // FIFO_CTRL1..4, COUNTER_BDR_REG1/2, INT1_CTRL, INT2_CTRL
+    { LSM6DSOX_CTRL1_XL, 10 },    // CTRL1_XL..CTRL10_C
+    { LSM6DSOX_TAP_CFG0, 10 },    // TAP_CFG0..MD2_CFG (wake-up, embedded interrupt routing)
+};
+
+static uint16_t crcUpdate(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static uint16_t imageCrc(const uint8_t* regs) {
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < IMU_SNAPSHOT_BYTES; i++) {
+        crc = crcUpdate(crc, regs[i]);
+    }
+    return crc;
+}
+
+static bool readImage(LSM6DSOXSensor& sensor, uint8_t* regs) {
+    int offset = 0;
+    for (const RegBlock& block : snapshotBlocks) {
+        if (sensor.Read_Reg_Burst(block.first, &regs[offset], block.count) != LSM6DSOX_OK) {
+            return false;
+        }
+        offset += block.count;
+    }
+    return true;
+}
+
+bool imuSnapshotSave(LSM6DSOXSensor& sensor, uint8_t model, uint16_t mlcChecksum) {
+    uint8_t regs[IMU_SNAPSHOT_BYTES];
+    if (!readImage(sensor, regs)) {
+        return false;
+    }
+
+    uint32_t words[SNAPSHOT_WORDS];
+    memset(words, 0, sizeof(words));
+    words[0] = ((uint32_t)SNAPSHOT_MAGIC << 16) | ((uint32_t)SNAPSHOT_VERSION << 8) | model;
+    words[1] = ((uint32_t)mlcChecksum << 16) | imageCrc(regs);
+    for (int i = 0; i < IMU_SNAPSHOT_BYTES; i++) {
+        words[2 + i / 4] |= (uint32_t)regs[i] << (8 * (i % 4));
+    }
+
+    enableBackupDomain();
+
+    // Header last, so a reset mid-save leaves an invalid snapshot rather than a torn one
+    setBackupRegister(IMU_SNAPSHOT_BKP_FIRST, 0);
+    for (int i = 1; i < SNAPSHOT_WORDS; i++) {
+        setBackupRegister(IMU_SNAPSHOT_BKP_FIRST + i, words[i]);
+    }
+    setBackupRegister(IMU_SNAPSHOT_BKP_FIRST, words[0]);
+    return true;
+}
+
+bool imuSnapshotLoad(ImuSnapshot* snapshot) {
+    uint32_t header = getBackupRegister(IMU_SNAPSHOT_BKP_FIRST);
+    if ((header >> 16) != SNAPSHOT_MAGIC || ((header >> 8) & 0xFF) != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    uint32_t sums = getBackupRegister(IMU_SNAPSHOT_BKP_FIRST + 1);
+    for (int i = 0; i < IMU_SNAPSHOT_BYTES; i++) {
+        uint32_t word = getBackupRegister(IMU_SNAPSHOT_BKP_FIRST + 2 + i / 4);
+        snapshot->regs[i] = (uint8_t)(word >> (8 * (i % 4)));
+    }
+
+    if (imageCrc(snapshot->regs) != (uint16_t)(sums & 0xFFFF)) {
+        return false;
+    }
+
+    snapshot->model = header & 0xFF;
+    snapshot->mlcChecksum = (uint16_t)(sums >> 16);
+    return true;
+}
+
+bool imuSnapshotRestore(LSM6DSOXSensor& sensor, const ImuSnapshot& snapshot, int* restored) {
+    uint8_t live[IMU_SNAPSHOT_BYTES];
+    int writes = 0;
+
+    if (restored != nullptr) {
+        *restored = 0;
+    }
+
+    if (!readImage(sensor, live)) {
+        return false;
+    }
+
+    int offset = 0;
+    for (const RegBlock& block : snapshotBlocks) {
+        for (int i = 0; i < block.count; i++, offset++) {
+            if (live[offset] == snapshot.regs[offset]) {
+                continue;
+            }
+            if (sensor.Write_Reg(block.first + i, snapshot.regs[offset]) != LSM6DSOX_OK) {
+                return false;
+            }
+            writes++;
+        }
+    }
+
+    if (restored != nullptr) {
+        *restored = writes;
+    }
+    return true;
+}
+
+void imuSnapshotClear() {
+    enableBackupDomain();
+    setBackupRegister(IMU_SNAPSHOT_BKP_FIRST, 0);
+}
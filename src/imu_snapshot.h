@@ -0,0 +1,47 @@
+#ifndef IMU_SNAPSHOT_H
+#define IMU_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "LSM6DSOXSensor.h"
+
+// Configuration image of the LSM6DSOX kept across MCU resets, so a warm boot
+// can skip begin(), the capture config and the UCF load when the sensor kept power.
+//
+// The STM32L433 has no backup SRAM, so the image lives in RTC backup registers
+// (32 x 32 bit, kept through reset and on VBAT). The embedded MLC pages do not fit;
+// the snapshot stores the model index and program checksum instead, and the pages
+// are checked against the program in flash with the UCF signature read-back.
+
+// First RTC backup register used; the lower ones are left to the RTC library
+#define IMU_SNAPSHOT_BKP_FIRST 16
+
+// Register blocks captured: FIFO_CTRL1..INT2_CTRL, CTRL1_XL..CTRL10_C, TAP_CFG0..MD2_CFG
+#define IMU_SNAPSHOT_BYTES 28
+
+struct ImuSnapshot {
+    uint8_t model;              // MLC model index (MlcModelManager order)
+    uint16_t mlcChecksum;       // ucfChecksum() of that program
+    uint8_t regs[IMU_SNAPSHOT_BYTES];
+};
+
+// Outcome of the boot-time restore, reported with the MLC load
+struct ImuRestoreReport {
+    bool warm;                  // snapshot matched a sensor that kept its configuration
+    int restored;               // registers that differed and were rewritten
+    unsigned long durationUs;
+};
+
+// Read the user-bank configuration and store it with the running model
+bool imuSnapshotSave(LSM6DSOXSensor& sensor, uint8_t model, uint16_t mlcChecksum);
+
+// Fetch the stored snapshot; false when none was saved or it is corrupt
+bool imuSnapshotLoad(ImuSnapshot* snapshot);
+
+// Compare the live registers with the snapshot and rewrite the ones that differ.
+// restored (may be nullptr) receives the number of registers written.
+bool imuSnapshotRestore(LSM6DSOXSensor& sensor, const ImuSnapshot& snapshot, int* restored);
+
+// Forget the snapshot, e.g. before deliberately reconfiguring the sensor
+void imuSnapshotClear();
+
+#endif // IMU_SNAPSHOT_H
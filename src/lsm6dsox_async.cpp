@@ -0,0 +1,150 @@
+#include "lsm6dsox_async.h"
+
+LSM6DSOXAsync::LSM6DSOXAsync(LSM6DSOXSensor* s, uint8_t address) : sensor(s),
+    address7((address >> 1) & 0x7F), head(0), count(0), running(false) {
+}
+
+bool LSM6DSOXAsync::read(uint8_t reg, uint8_t* data, uint16_t len,
+                         LSM6DSOXAsyncCallback callback, void* context) {
+    return enqueue(false, reg, data, len, callback, context);
+}
+
+bool LSM6DSOXAsync::write(uint8_t reg, const uint8_t* data, uint16_t len,
+                          LSM6DSOXAsyncCallback callback, void* context) {
+    return enqueue(true, reg, (uint8_t*)data, len, callback, context);
+}
+
+bool LSM6DSOXAsync::read(uint8_t reg, uint8_t* data, uint16_t len, LSM6DSOXFuture* future) {
+    future->done = false;
+    return enqueue(false, reg, data, len, completeFuture, future);
+}
+
+bool LSM6DSOXAsync::write(uint8_t reg, const uint8_t* data, uint16_t len, LSM6DSOXFuture* future) {
+    future->done = false;
+    return enqueue(true, reg, (uint8_t*)data, len, completeFuture, future);
+}
+
+void LSM6DSOXAsync::completeFuture(LSM6DSOXStatusTypeDef status, void* context) {
+    LSM6DSOXFuture* future = (LSM6DSOXFuture*)context;
+    future->status = status;
+    future->done = true;
+}
+
+bool LSM6DSOXAsync::enqueue(bool write, uint8_t reg, uint8_t* data, uint16_t len,
+                            LSM6DSOXAsyncCallback callback, void* context) {
+    if (len == 0) {
+        return false;
+    }
+
+    noInterrupts();
+    if (count >= LSM6DSOX_ASYNC_QUEUE_DEPTH) {
+        interrupts();
+        return false;
+    }
+
+    Transaction& t = queue[(head + count) % LSM6DSOX_ASYNC_QUEUE_DEPTH];
+    t.write = write;
+    t.reg = reg;
+    t.len = len;
+    t.callback = callback;
+    t.context = context;
+    if (write && len <= LSM6DSOX_ASYNC_INLINE_BYTES) {
+        memcpy(t.inlineData, data, len);
+        t.data = t.inlineData;
+    } else {
+        t.data = data;
+    }
+    count++;
+
+    bool start = !running;
+    interrupts();
+
+    // Writes may change anything the driver has shadowed
+    if (write) {
+        sensor->Invalidate_Shadow();
+    }
+
+    if (start) {
+        startNext();
+    }
+    return true;
+}
+
+void LSM6DSOXAsync::startNext() {
+    while (count > 0) {
+        Transaction& t = queue[head];
+        running = true;
+
+        if (!i2cDmaAvailable()) {
+            runSynchronously(t);
+            continue;
+        }
+
+        bool started = t.write ? i2cDmaWriteStart(address7, t.reg, t.data, t.len, onTransferDone, this)
+                               : i2cDmaReadStart(address7, t.reg, t.data, t.len, onTransferDone, this);
+        if (started) {
+            return;
+        }
+
+        // Could not start on the bus: fail this one and move on
+        LSM6DSOXAsyncCallback callback = t.callback;
+        void* context = t.context;
+        head = (head + 1) % LSM6DSOX_ASYNC_QUEUE_DEPTH;
+        count--;
+        if (callback != nullptr) {
+            callback(LSM6DSOX_ERROR, context);
+        }
+    }
+
+    running = false;
+}
+
+void LSM6DSOXAsync::runSynchronously(Transaction& t) {
+    LSM6DSOXStatusTypeDef status = t.write ? sensor->Write_Reg_Burst(t.reg, t.data, t.len)
+                                           : sensor->Read_Reg_Burst(t.reg, t.data, t.len);
+
+    LSM6DSOXAsyncCallback callback = t.callback;
+    void* context = t.context;
+    head = (head + 1) % LSM6DSOX_ASYNC_QUEUE_DEPTH;
+    count--;
+    if (callback != nullptr) {
+        callback(status, context);
+    }
+}
+
+// Runs in interrupt context (or from poll() on errors)
+void LSM6DSOXAsync::onTransferDone(bool ok, void* context) {
+    LSM6DSOXAsync* self = (LSM6DSOXAsync*)context;
+    Transaction& t = self->queue[self->head];
+
+    LSM6DSOXAsyncCallback callback = t.callback;
+    void* callbackContext = t.context;
+    self->head = (self->head + 1) % LSM6DSOX_ASYNC_QUEUE_DEPTH;
+    self->count--;
+
+    if (callback != nullptr) {
+        callback(ok ? LSM6DSOX_OK : LSM6DSOX_ERROR, callbackContext);
+    }
+
+    self->startNext();
+}
+
+bool LSM6DSOXAsync::isIdle() {
+    return count == 0;
+}
+
+void LSM6DSOXAsync::poll() {
+    if (running) {
+        i2cDmaPoll();
+    }
+}
+
+void LSM6DSOXAsync::waitIdle() {
+    while (count > 0) {
+        poll();
+        if (count > 0) {
+            // I2C, DMA and SysTick interrupts all wake the core again
+            __WFI();
+        }
+    }
+}
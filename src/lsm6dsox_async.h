@@ -0,0 +1,76 @@
+#ifndef LSM6DSOX_ASYNC_H
+#define LSM6DSOX_ASYNC_H
+
+#include <Arduino.h>
+#include "LSM6DSOXSensor.h"
+#include "i2c_dma.h"
+
+// Queued LSM6DSOX register transactions completed from the I2C/DMA interrupts.
+// Each completion starts the next queued transaction, so a whole sequence runs
+// while the caller blinks, sleeps or waits. Without LSM6DSOX_I2C_DMA every
+// transaction runs synchronously when it is queued and completes immediately.
+//
+// The bus is shared with the Notecard: call waitIdle() before Notecard requests.
+// Synchronous LSM6DSOXSensor calls wait for the queue on their own.
+
+#define LSM6DSOX_ASYNC_QUEUE_DEPTH 8
+
+// Writes up to this size are copied into the queue entry
+#define LSM6DSOX_ASYNC_INLINE_BYTES 4
+
+typedef void (*LSM6DSOXAsyncCallback)(LSM6DSOXStatusTypeDef status, void* context);
+
+// Completion flag for callers that poll or wait instead of taking a callback
+struct LSM6DSOXFuture {
+    volatile bool done;
+    volatile LSM6DSOXStatusTypeDef status;
+};
+
+class LSM6DSOXAsync {
+private:
+    struct Transaction {
+        bool write;
+        uint8_t reg;
+        uint8_t* data;
+        uint16_t len;
+        uint8_t inlineData[LSM6DSOX_ASYNC_INLINE_BYTES];
+        LSM6DSOXAsyncCallback callback;
+        void* context;
+    };
+
+    LSM6DSOXSensor* sensor;
+    uint8_t address7;
+
+    Transaction queue[LSM6DSOX_ASYNC_QUEUE_DEPTH];
+    volatile uint8_t head;
+    volatile uint8_t count;
+    volatile bool running;
+
+    bool enqueue(bool write, uint8_t reg, uint8_t* data, uint16_t len,
+                 LSM6DSOXAsyncCallback callback, void* context);
+    void startNext();
+    void runSynchronously(Transaction& t);
+    static void onTransferDone(bool ok, void* context);
+    static void completeFuture(LSM6DSOXStatusTypeDef status, void* context);
+
+public:
+    // address is the 8-bit address the driver takes (LSM6DSOX_I2C_ADD_L/H)
+    LSM6DSOXAsync(LSM6DSOXSensor* sensor, uint8_t address);
+
+    // Queue a transaction; false when the queue is full. Read buffers (and
+    // writes longer than LSM6DSOX_ASYNC_INLINE_BYTES) must stay valid until completion.
+    bool read(uint8_t reg, uint8_t* data, uint16_t len, LSM6DSOXAsyncCallback callback, void* context);
+    bool write(uint8_t reg, const uint8_t* data, uint16_t len, LSM6DSOXAsyncCallback callback, void* context);
+    bool read(uint8_t reg, uint8_t* data, uint16_t len, LSM6DSOXFuture* future);
+    bool write(uint8_t reg, const uint8_t* data, uint16_t len, LSM6DSOXFuture* future);
+
+    bool isIdle();
+
+    // Check the running transfer for errors and timeouts
+    void poll();
+
+    // Sleep (WFI) until every queued transaction completed
+    void waitIdle();
+};
+
+#endif // LSM6DSOX_ASYNC_H
@@ -0,0 +1,226 @@
+/**
+ ******************************************************************************
+ * @file    lsm6dsox_bus.h
+ * @brief   Register transfer helpers and compile-time bus policies for the
+ *          LSM6DSOX
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __LSM6DSOX_BUS_H__
+#define __LSM6DSOX_BUS_H__
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "Wire.h"
+#include "SPI.h"
+#include "lsm6dsox_reg.h"
+#include "i2c_dma.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Longest I2C read done in one Wire transaction: requestFrom() takes a uint8_t
+   length, rounded down to whole FIFO words (36 x 7 bytes) */
+#define LSM6DSOX_I2C_MAX_CHUNK  252U
+
+/* Fastest SPI clock the LSM6DSOX accepts (datasheet table 8) */
+#define LSM6DSOX_SPI_FAST_HZ  10000000U
+
+
+/* Transfer helpers ----------------------------------------------------------*/
+
+/**
+ * @brief  I2C register read, shared by the runtime driver and the I2C bus policy
+ * @param  i2c: bus the sensor is on.
+ * @param  addr7: 7-bit device address.
+ * @param  pBuffer: pointer to data to be read.
+ * @param  RegisterAddr: specifies internal address register to be read.
+ * @param  NumByteToRead: number of bytes to be read.
+ * @retval 0 if ok, an error code otherwise.
+ */
+static inline uint8_t LSM6DSOX_I2C_Read(TwoWire *i2c, uint8_t addr7, uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+{
+  /* Let queued asynchronous transactions finish first */
+  i2cDmaWaitIdle();
+
+  /* Bulk reads (FIFO drains) go through DMA while the core sleeps */
+  if (NumByteToRead >= I2C_DMA_MIN_BYTES && i2cDmaAvailable() &&
+      i2cDmaRead(addr7, RegisterAddr, pBuffer, NumByteToRead)) {
+    return 0;
+  }
+
+  /* requestFrom() takes at most 255 bytes, so longer reads are split in
+     chunks of whole FIFO words; FIFO_DATA_OUT wraps back to the tag byte,
+     every other register block keeps incrementing */
+  uint16_t offset = 0;
+  while (offset < NumByteToRead) {
+    uint16_t chunk = NumByteToRead - offset;
+    if (chunk > LSM6DSOX_I2C_MAX_CHUNK) {
+      chunk = LSM6DSOX_I2C_MAX_CHUNK;
+    }
+    uint8_t reg = (RegisterAddr == LSM6DSOX_FIFO_DATA_OUT_TAG) ? RegisterAddr : (uint8_t)(RegisterAddr + offset);
+
+    i2c->beginTransmission(addr7);
+    i2c->write(reg);
+    i2c->endTransmission(false);
+
+    if (i2c->requestFrom(addr7, (uint8_t) chunk) != chunk) {
+      return 1;
+    }
+
+    for (uint16_t i = 0; i < chunk && i2c->available(); i++) {
+      pBuffer[offset + i] = i2c->read();
+    }
+    offset += chunk;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  I2C register write, shared by the runtime driver and the I2C bus policy
+ * @param  i2c: bus the sensor is on.
+ * @param  addr7: 7-bit device address.
+ * @param  pBuffer: pointer to data to be written.
+ * @param  RegisterAddr: specifies internal address register to be written.
+ * @param  NumByteToWrite: number of bytes to write.
+ * @retval 0 if ok, an error code otherwise.
+ */
+static inline uint8_t LSM6DSOX_I2C_Write(TwoWire *i2c, uint8_t addr7, const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+{
+  i2cDmaWaitIdle();
+
+  i2c->beginTransmission(addr7);
+
+  i2c->write(RegisterAddr);
+  for (uint16_t i = 0 ; i < NumByteToWrite ; i++) {
+    i2c->write(pBuffer[i]);
+  }
+
+  /* A NACK must reach the caller, or the shadow cache keeps a value the chip never got */
+  return i2c->endTransmission(true) != 0;
+}
+
+/**
+ * @brief  SPI register read, shared by the runtime driver and the SPI bus policy
+ * @param  spi: bus the sensor is on.
+ * @param  cs_pin: chip select pin.
+ * @param  spi_speed: SPI clock in Hz.
+ * @param  pBuffer: pointer to data to be read.
+ * @param  RegisterAddr: specifies internal address register to be read.
+ * @param  NumByteToRead: number of bytes to be read.
+ * @retval 0 if ok, an error code otherwise.
+ */
+static inline uint8_t LSM6DSOX_SPI_Read(SPIClass *spi, int cs_pin, uint32_t spi_speed, uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+{
+  spi->beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
+
+  digitalWrite(cs_pin, LOW);
+
+  /* Write Reg Address */
+  spi->transfer(RegisterAddr | 0x80);
+  /* Read the data in one buffer transfer; what is clocked out is ignored */
+  spi->transfer(pBuffer, NumByteToRead);
+
+  digitalWrite(cs_pin, HIGH);
+
+  spi->endTransaction();
+
+  return 0;
+}
+
+/**
+ * @brief  SPI register write, shared by the runtime driver and the SPI bus policy
+ * @param  spi: bus the sensor is on.
+ * @param  cs_pin: chip select pin.
+ * @param  spi_speed: SPI clock in Hz.
+ * @param  pBuffer: pointer to data to be written.
+ * @param  RegisterAddr: specifies internal address register to be written.
+ * @param  NumByteToWrite: number of bytes to write.
+ * @retval 0 if ok, an error code otherwise.
+ */
+static inline uint8_t LSM6DSOX_SPI_Write(SPIClass *spi, int cs_pin, uint32_t spi_speed, const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+{
+  spi->beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
+
+  digitalWrite(cs_pin, LOW);
+
+  /* Write Reg Address */
+  spi->transfer(RegisterAddr);
+  /* Write the data */
+  for (uint16_t i = 0; i < NumByteToWrite; i++) {
+    spi->transfer(pBuffer[i]);
+  }
+
+  digitalWrite(cs_pin, HIGH);
+
+  spi->endTransaction();
+
+  return 0;
+}
+
+
+/* Bus policies --------------------------------------------------------------*/
+
+/* A bus policy is a type with three static members, all resolved at compile time:
+     static void begin();
+     static uint8_t read(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead);
+     static uint8_t write(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite);
+   read and write return 0 if ok, an error code otherwise. */
+
+/**
+ * @brief  LSM6DSOX on an I2C bus
+ * @param  Bus: the TwoWire instance, e.g. Wire.
+ * @param  Address: 8-bit device address, LSM6DSOX_I2C_ADD_L or LSM6DSOX_I2C_ADD_H.
+ */
+template <TwoWire &Bus, uint8_t Address>
+struct LSM6DSOXI2CBus
+{
+  static const uint8_t addr7 = (uint8_t)((Address >> 1) & 0x7F);
+
+  static void begin()
+  {
+    /* Bulk reads use DMA when built with LSM6DSOX_I2C_DMA */
+    i2cDmaBegin(&Bus);
+  }
+
+  static inline uint8_t read(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+  {
+    return LSM6DSOX_I2C_Read(&Bus, addr7, pBuffer, RegisterAddr, NumByteToRead);
+  }
+
+  static inline uint8_t write(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+  {
+    return LSM6DSOX_I2C_Write(&Bus, addr7, pBuffer, RegisterAddr, NumByteToWrite);
+  }
+};
+
+/**
+ * @brief  LSM6DSOX on an SPI bus (mode 3); defaults to the 10 MHz the sensor allows
+ * @param  Bus: the SPIClass instance, e.g. SPI.
+ * @param  CsPin: chip select pin.
+ * @param  Speed: SPI clock in Hz.
+ */
+template <SPIClass &Bus, int CsPin, uint32_t Speed = LSM6DSOX_SPI_FAST_HZ>
+struct LSM6DSOXSPIBus
+{
+  static void begin()
+  {
+    pinMode(CsPin, OUTPUT);
+    digitalWrite(CsPin, HIGH);
+  }
+
+  static inline uint8_t read(uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToRead)
+  {
+    return LSM6DSOX_SPI_Read(&Bus, CsPin, Speed, pBuffer, RegisterAddr, NumByteToRead);
+  }
+
+  static inline uint8_t write(const uint8_t *pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
+  {
+    return LSM6DSOX_SPI_Write(&Bus, CsPin, Speed, pBuffer, RegisterAddr, NumByteToWrite);
+  }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include <STM32LowPower.h>
 #include <STM32RTC.h>
 #include <Notecard.h>
+#include <stm32yyxx_ll_rtc.h>
 #include "data_mode.h"
 #include "collect_mode.h"
 
@@ -9,10 +10,24 @@
 const int WAKE_PIN = D6;
 volatile bool wokeByPin = false;
 
+// D5 interrupt pin for the FIFO watermark (LSM6DSOX INT2) during capture
+const int FIFO_WAKE_PIN = D5;
+volatile bool fifoReady = false;
+
+// Extra sleep allowed past the expected batch time before the timer wakes us
+#define FIFO_WAKE_MARGIN_MS 250
+
+// 1: captures go out through card.binary as one captures.qo note; 0: base64 sensors.qo notes
+#define BULK_UPLOAD 1
+
+// Upper bound on the RTC shadow register resync after a wake (two RTCCLK cycles, ~61 us)
+#define RTC_SYNC_TIMEOUT_US 1000
+
 STM32RTC& rtc = STM32RTC::getInstance();
 Notecard notecard;
 DataMode dataMode;
 CollectMode collectMode;
+SyncPolicy syncPolicy;
 
 // Variables for flow control
 bool dataModeDone = false;
@@ -23,29 +38,63 @@ unsigned long storedUTCTimestamp = 0;
 struct StateEvent {
     unsigned long startTime;
     unsigned long endTime;
+    uint16_t startMs;  // millisecond parts of the times above
+    uint16_t endMs;
     int stateLog;
 };
 StateEvent stateEvents[MAX_STATE_EVENTS];
 int stateEventCount = 0;
 unsigned long lastStateTime = 0;
+uint16_t lastStateMs = 0;
 uint8_t previousMlcState = 0;
 int interruptOccurred = 0;  // Track if any interrupts happened during cycle
+bool mlcEventPending = false;  // MLC event latch queued for this wake
+
+// RTC time taken first thing after a pin wake, stamped on the MLC event
+unsigned long wakeEpoch = 0;
+uint16_t wakeMs = 0;
 
-// Interrupt Service Routine
+// Interrupt Service Routine. Only the flag: reading the RTC here would race the
+// clock restore after Stop mode and any getEpoch() the main loop is in
 void onWakePin() {
     wokeByPin = true;
 }
 
+// After Stop mode the calendar shadow registers keep the time the MCU went to
+// sleep until the next resync; wait for RSF before reading the RTC
+void waitRtcSync() {
+    LL_RTC_DisableWriteProtection(RTC);
+    LL_RTC_ClearFlag_RS(RTC);
+    LL_RTC_EnableWriteProtection(RTC);
+
+    unsigned long start = micros();
+    while (!LL_RTC_IsActiveFlag_RS(RTC) && micros() - start < RTC_SYNC_TIMEOUT_US) {
+    }
+}
+
+// FIFO watermark Interrupt Service Routine
+void onFifoWatermark() {
+    fifoReady = true;
+}
+
+// MLC tree output changed: latch the outputs and sensor timestamp now,
+// the transfers run from interrupts while the LED blinks
+void onMlcEvent(const ImuEvent& event, void*) {
+    mlcEventPending = dataMode.requestMlcEvent((uint8_t)event.detail, wakeEpoch, wakeMs);
+}
+
 // Read current MLC state from data mode
 uint8_t getCurrentMlcState() {
     return dataMode.getCurrentMlcState();
 }
 
 // Add state event to the log
-void addStateEvent(unsigned long startTime, unsigned long endTime, uint8_t mlcState) {
+void addStateEvent(unsigned long startTime, uint16_t startMs, unsigned long endTime, uint16_t endMs, uint8_t mlcState) {
     if (stateEventCount < MAX_STATE_EVENTS) {
         stateEvents[stateEventCount].startTime = startTime;
         stateEvents[stateEventCount].endTime = endTime;
+        stateEvents[stateEventCount].startMs = startMs;
+        stateEvents[stateEventCount].endMs = endMs;
         stateEvents[stateEventCount].stateLog = mlcState;  // Use provided MLC state
         stateEventCount++;
 
@@ -53,11 +102,43 @@ void addStateEvent(unsigned long startTime, unsigned long endTime, uint8_t mlcSt
     }
 }
 
+// Sleep through the post-trigger window; further D6 edges stay pending in wokeByPin
+void sleepPostTrigger(unsigned long windowMs) {
+    uint32_t startSub = 0;
+    uint32_t startSec = rtc.getEpoch(&startSub);
+
+    while (true) {
+        uint32_t nowSub = 0;
+        uint32_t nowSec = rtc.getEpoch(&nowSub);
+        long elapsed = (long)(nowSec - startSec) * 1000L + (long)nowSub - (long)startSub;
+
+        if (elapsed >= (long)windowMs) {
+            break;
+        }
+        LowPower.deepSleep(windowMs - elapsed);
+        waitRtcSync();
+    }
+}
+
 // Handle interrupt wake - log state transition
 void handleInterruptWake() {
     if (wokeByPin) {
         wokeByPin = false;  // Clear flag
 
+        // Transition time: taken before anything else, to the millisecond
+        waitRtcSync();
+        uint32_t subSeconds = 0;
+        wakeEpoch = rtc.isTimeSet() ? rtc.getEpoch(&subSeconds) : 0;
+        wakeMs = wakeEpoch ? (uint16_t)subSeconds : 0;
+
+        // One burst attributes the wake; an MLC change latches the outputs.
+        // The MLC status bit is pulsed and may have dropped by the time a late
+        // edge is handled, so a wake with no source (or a bus error) latches them too.
+        mlcEventPending = false;
+        if (dataMode.getImuEvents().poll() <= 0 && !mlcEventPending) {
+            mlcEventPending = dataMode.requestMlcEvent(0, wakeEpoch, wakeMs);
+        }
+
         // Quick double blink to indicate interrupt detected
         digitalWrite(LED_BUILTIN, HIGH);
         delay(100);
@@ -67,22 +148,34 @@ void handleInterruptWake() {
         delay(100);
         digitalWrite(LED_BUILTIN, LOW);
 
-        unsigned long currentTime = rtc.isTimeSet() ? rtc.getEpoch() : 0;
+        unsigned long currentTime = wakeEpoch;
 
         // Mark that an interrupt occurred this cycle
         interruptOccurred = 1;
 
-        // Get current MLC state to check for actual state change
-        uint8_t currentMlcState = getCurrentMlcState();
+        // MLC state latched at interrupt time, not after the blink
+        uint8_t currentMlcState = previousMlcState;
+        MlcEvent mlcEvent;
+        if (mlcEventPending && dataMode.takeMlcEvent(&mlcEvent)) {
+            currentMlcState = mlcEvent.outputs[0];
+        }
+        mlcEventPending = false;
 
         // Only log if state actually changed
         if (lastStateTime > 0 && currentMlcState != previousMlcState) {
             // Log the previous state (from lastStateTime to current time)
-            addStateEvent(lastStateTime, currentTime, previousMlcState);
+            addStateEvent(lastStateTime, lastStateMs, currentTime, wakeMs, previousMlcState);
+
+            // Let the ring record the post-trigger window, then queue the waveform
+            if (dataMode.isPreTriggerArmed()) {
+                sleepPostTrigger(dataMode.getPostTriggerMs());
+                dataMode.capturePreTrigger(previousMlcState, currentMlcState, currentTime);
+            }
 
             // Update previous state and last state time for next transition
             previousMlcState = currentMlcState;
             lastStateTime = currentTime;
+            lastStateMs = wakeMs;
         }
 
     }
@@ -93,8 +186,9 @@ void setup() {
   // Configure LED pin
   pinMode(LED_BUILTIN, OUTPUT);
 
-  // Configure interrupt pin
+  // Configure interrupt pins
   pinMode(WAKE_PIN, INPUT_PULLDOWN);
+  pinMode(FIFO_WAKE_PIN, INPUT_PULLDOWN);
 
   // Initialize the low power library
   LowPower.begin();
@@ -143,16 +237,47 @@ void setup() {
   // Initialize LSM6DSOX sensor (don't auto-start logging)
   dataMode.begin(&notecard);
 
+  // Wake attribution: MLC changes are the only source routed to D6
+  dataMode.getImuEvents().on(IMU_EVENT_MLC, onMlcEvent, nullptr);
+
   // Initialize collect mode with data_mode reference
   collectMode.begin(&notecard, &dataMode);
 
+  // State events go out as fixed-length templated records
+  collectMode.registerTemplates();
+
+  // Notes queue on the Notecard and share one session: hub.sync only for
+  // transition waveforms, 48 KB of queued notes or a 4 hour old note
+  syncPolicy.begin(&notecard);
+  dataMode.setSyncPolicy(&syncPolicy);
+  collectMode.setSyncPolicy(&syncPolicy);
+  collectMode.setBulkUpload(BULK_UPLOAD != 0);
+
   // Stop any auto-started logging to control it manually
   if (dataMode.getIsLogging()) {
     dataMode.stopLogging();
   }
 
-  // Attach interrupt for wake from deep sleep
+  // Batch capture samples in the sensor FIFO so the MCU can sleep between drains
+  dataMode.setCaptureMode(CAPTURE_MODE_FIFO);
+  dataMode.setFifoInterruptPin(LSM6DSOX_INT2_PIN);
+
+  // Keep raw int16 counts: twice the samples per byte of RAM and half the uplink
+  dataMode.setSampleStorage(STORAGE_RAW_INT16);
+
+  // Let the sensor delta-compress FIFO words; up to 3 samples per 7-byte word
+  dataMode.setFifoCompression(LSM6DSOX_CMP_16_TO_1);
+
+  // Batch the sensor timestamp with every sample so uploads carry exact time offsets
+  dataMode.setFifoTimestamps(true);
+
+  // Capture at the MLC operating point; PROFILE_VIBRATION_416HZ and
+  // PROFILE_BURST_1666HZ trade window length for bandwidth
+  dataMode.setCaptureProfile(PROFILE_MLC_26HZ);
+
+  // Attach interrupts for wake from deep sleep
   LowPower.attachInterruptWakeup(WAKE_PIN, onWakePin, RISING);
+  LowPower.attachInterruptWakeup(FIFO_WAKE_PIN, onFifoWatermark, RISING);
 }
 
 void loop() {
@@ -165,17 +290,38 @@ void loop() {
       dataMode.stopLogging();
     }
 
+    fifoReady = false;
     dataMode.startLogging();
 
     while (dataMode.getIsLogging()) {
       dataMode.update();
-      delay(10);
+
+      if (!dataMode.getIsLogging()) {
+        break;
+      }
+
+      if (dataMode.getCaptureMode() == CAPTURE_MODE_FIFO) {
+        // Sleep until INT2 reports a full batch; the timer only covers the
+        // final partial batch and a missed edge
+        if (!fifoReady) {
+          LowPower.deepSleep(dataMode.getDrainIntervalMs() + FIFO_WAKE_MARGIN_MS);
+        }
+        fifoReady = false;
+      } else {
+        delay(10);
+      }
     }
 
     digitalWrite(LED_BUILTIN, LOW);
 
     // Immediately send sensors.qo with Format 1
-    collectMode.sendData(); // This sends to sensors.qo with acceleration data
+    collectMode.sendData(); // Capture to captures.qo in bulk mode, else sensors.qo
+
+    // Path, size and throughput of that upload, for comparing the two paths
+    collectMode.sendUploadStats();
+
+    // From now on the sensor FIFO keeps the recent past for state-change waveforms
+    dataMode.armPreTrigger();
 
     dataModeDone = true;
   }
@@ -197,6 +343,7 @@ void loop() {
     if (stateEventCount == 0 && lastStateTime == 0) {
         // First-time initialization
         lastStateTime = result.unixTime;
+        lastStateMs = 0;
         previousMlcState = getCurrentMlcState();
     }
     // Always reset interrupt counter for new cycle
@@ -230,6 +377,7 @@ void loop() {
     // Deep sleep for remaining time (or max 30 minutes)
     unsigned long sleepTime = remainingSleepMS > 1800000 ? 1800000 : remainingSleepMS;
     LowPower.deepSleep(sleepTime);
+    waitRtcSync();
 
     // Check if we woke by interrupt
     if (wokeByPin) {
@@ -249,6 +397,9 @@ void loop() {
 
   // Wake up by timer expiry - normal cycle
 
+  // Quiet cycles add no notes, so the age threshold is checked here
+  syncPolicy.poll(rtc.isTimeSet() ? rtc.getEpoch() : 0);
+
   // Check if any interrupts occurred during this 30-minute cycle
   if (interruptOccurred == 0) {
     return; // Go back to sleep immediately - huge power savings!
@@ -257,8 +408,9 @@ void loop() {
 
   // Get current RTC time (should be ~30 minutes after stored time)
   unsigned long currentRTCTime = 0;
+  uint32_t currentRTCMs = 0;
   if (rtc.isTimeSet()) {
-    currentRTCTime = rtc.getEpoch();
+    currentRTCTime = rtc.getEpoch(&currentRTCMs);
   } else {
     currentRTCTime = storedUTCTimestamp + 1800; // Fallback: assume 30 minutes passed
   }
@@ -266,22 +418,26 @@ void loop() {
   // Add final state event with current state lasting until now
   // Only add if we have accumulated time in the current state
   if (lastStateTime > 0 && lastStateTime < currentRTCTime) {
-    addStateEvent(lastStateTime, currentRTCTime, previousMlcState);
+    addStateEvent(lastStateTime, lastStateMs, currentRTCTime, (uint16_t)currentRTCMs, previousMlcState);
   }
 
   // Extract arrays from StateEvent structs
   unsigned long startTimes[MAX_STATE_EVENTS];
   unsigned long endTimes[MAX_STATE_EVENTS];
+  uint16_t startMs[MAX_STATE_EVENTS];
+  uint16_t endMs[MAX_STATE_EVENTS];
   int stateLogs[MAX_STATE_EVENTS];
 
   for (int i = 0; i < stateEventCount; i++) {
     startTimes[i] = stateEvents[i].startTime;
     endTimes[i] = stateEvents[i].endTime;
+    startMs[i] = stateEvents[i].startMs;
+    endMs[i] = stateEvents[i].endMs;
     stateLogs[i] = stateEvents[i].stateLog;
   }
 
   // Send data.qo with Format 2 (all state events)
-  collectMode.sendAllStateEvents(startTimes, endTimes, stateLogs, stateEventCount);
+  collectMode.sendAllStateEvents(startTimes, endTimes, stateLogs, stateEventCount, startMs, endMs);
 
   // Disable interrupts during critical cleanup to prevent race conditions
   noInterrupts();
@@ -291,6 +447,7 @@ void loop() {
   if (stateEventCount > 0) {
     // Get the final state's end time and state for next cycle continuity
     lastStateTime = stateEvents[stateEventCount - 1].endTime;
+    lastStateMs = stateEvents[stateEventCount - 1].endMs;
     previousMlcState = stateEvents[stateEventCount - 1].stateLog;
   }
 
@@ -0,0 +1,113 @@
+#include "mlc_models.h"
+#include "imu_snapshot.h"
+
+MlcModelManager::MlcModelManager() : sensor(nullptr), modelCount(0), active(-1) {
+    memset(models, 0, sizeof(models));
+    memset(&lastReport, 0, sizeof(lastReport));
+}
+
+void MlcModelManager::begin(LSM6DSOXSensor* s) {
+    sensor = s;
+    active = -1;
+}
+
+int MlcModelManager::registerModel(const UcfProgram* program) {
+    if (modelCount >= MLC_MAX_MODELS) {
+        return -1;
+    }
+
+    models[modelCount] = program;
+    return modelCount++;
+}
+
+bool MlcModelManager::load(int index) {
+    if (sensor == nullptr || index < 0 || index >= modelCount) {
+        return false;
+    }
+
+    if (!ucfLoad(*sensor, *models[index], &lastReport)) {
+        active = -1;
+        return false;
+    }
+
+    active = index;
+    return true;
+}
+
+bool MlcModelManager::resume(int index, uint16_t checksum) {
+    if (sensor == nullptr || index < 0 || index >= modelCount) {
+        return false;
+    }
+
+    unsigned long start = micros();
+
+    // A firmware update may have changed the program behind the same index
+    if (ucfChecksum(*models[index]) != checksum || !ucfSignatureMatches(*sensor, *models[index])) {
+        return false;
+    }
+
+    lastReport.skipped = true;
+    lastReport.verified = true;
+    lastReport.checksum = checksum;
+    lastReport.writes = 0;
+    lastReport.durationUs = micros() - start;
+
+    active = index;
+    return true;
+}
+
+bool MlcModelManager::activate(int index) {
+    if (sensor == nullptr || index < 0 || index >= modelCount) {
+        return false;
+    }
+
+    if (index == active) {
+        return true;
+    }
+
+    // The stored snapshot names the outgoing model
+    imuSnapshotClear();
+
+    if (!ucfLoadEmbedded(*sensor, *models[index], &lastReport)) {
+        // Half-written pages: nothing can be trusted to be running
+        active = -1;
+        return false;
+    }
+
+    active = index;
+    return true;
+}
+
+bool MlcModelManager::loadFsm(const uint8_t* programs, uint16_t len, uint8_t count, uint16_t startAddress) {
+    if (sensor == nullptr) {
+        return false;
+    }
+
+    for (int i = 0; i < modelCount; i++) {
+        if (ucfPagesOverlap(*models[i], startAddress, len)) {
+            return false;
+        }
+    }
+
+    return sensor->Load_FSM_Programs(programs, len, count, startAddress) == LSM6DSOX_OK;
+}
+
+uint16_t MlcModelManager::getActiveChecksum() {
+    return active >= 0 ? ucfChecksum(*models[active]) : 0;
+}
+
+int MlcModelManager::getActive() {
+    return active;
+}
+
+const char* MlcModelManager::getActiveName() {
+    return active >= 0 ? models[active]->name : "";
+}
+
+int MlcModelManager::getModelCount() {
+    return modelCount;
+}
+
+const UcfLoadReport& MlcModelManager::getLastReport() {
+    return lastReport;
+}
@@ -0,0 +1,53 @@
+#ifndef MLC_MODELS_H
+#define MLC_MODELS_H
+
+#include <Arduino.h>
+#include "LSM6DSOXSensor.h"
+#include "ucf_loader.h"
+
+// Registered MLC programs, e.g. coarse on/off while idle, movement while running
+#define MLC_MAX_MODELS 4
+
+class MlcModelManager {
+private:
+    LSM6DSOXSensor* sensor;
+    const UcfProgram* models[MLC_MAX_MODELS];
+    int modelCount;
+    int active;
+
+    // Result of the last load or switch
+    UcfLoadReport lastReport;
+
+public:
+    MlcModelManager();
+
+    void begin(LSM6DSOXSensor* sensor);
+
+    // Returns the model index, or -1 when the registry is full
+    int registerModel(const UcfProgram* program);
+
+    // Full load (skipped if already running), used at boot
+    bool load(int index);
+
+    // Adopt a model the sensor kept running across an MCU reset, without writing.
+    // checksum is the ucfChecksum() recorded when it was loaded.
+    bool resume(int index, uint16_t checksum);
+
+    // Runtime switch: rewrites the embedded-function bank only, no begin() re-init.
+    // All registered models must share the user-bank setup (26 Hz, 2 g, INT1 route).
+    // Clears the IMU snapshot; the caller saves a new one once the switch is done.
+    bool activate(int index);
+
+    // Load FSM programs into the embedded pages. Refused when the range overlaps
+    // the pages of any registered model, since activate() may bring it in later.
+    bool loadFsm(const uint8_t* programs, uint16_t len, uint8_t count,
+                 uint16_t startAddress = LSM6DSOX_START_FSM_ADD);
+
+    int getActive();
+    uint16_t getActiveChecksum();
+    const char* getActiveName();
+    int getModelCount();
+    const UcfLoadReport& getLastReport();
+};
+
+#endif // MLC_MODELS_H
@@ -0,0 +1,170 @@
+/**
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef MOVEMENT_H
+#define MOVEMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifndef MEMS_UCF_SHARED_TYPES
+#define MEMS_UCF_SHARED_TYPES
+
+/** Common data block definition **/
+typedef struct {
+  uint8_t address;
+  uint8_t data;
+} ucf_line_t;
+
+#endif /* MEMS_UCF_SHARED_TYPES */
+
+#ifndef MEMS_UCF_TABLE
+/* constexpr in C++ so ucf_packed.h can validate and pack the table at build time */
+#ifdef __cplusplus
+#define MEMS_UCF_TABLE constexpr
+#else
+#define MEMS_UCF_TABLE const
+#endif
+#endif /* MEMS_UCF_TABLE */
+
+/** Configuration array generated from Unico Tool **/
+MEMS_UCF_TABLE ucf_line_t movement[] = {
+  {.address = 0x10, .data = 0x00,},
+  {.address = 0x11, .data = 0x00,},
+  {.address = 0x01, .data = 0x80,},
+  {.address = 0x04, .data = 0x00,},
+  {.address = 0x05, .data = 0x00,},
+  {.address = 0x17, .data = 0x40,},
+  {.address = 0x02, .data = 0x11,},
+  {.address = 0x08, .data = 0xEA,},
+  {.address = 0x09, .data = 0x72,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x09, .data = 0x80,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x0A,},
+  {.address = 0x02, .data = 0x11,},
+  {.address = 0x08, .data = 0xF2,},
+  {.address = 0x09, .data = 0x1A,},
+  {.address = 0x02, .data = 0x11,},
+  {.address = 0x08, .data = 0xFA,},
+  {.address = 0x09, .data = 0x3C,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x09, .data = 0x8E,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x09, .data = 0x9A,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x02, .data = 0x31,},
+  {.address = 0x08, .data = 0x3C,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x03,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x3F,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x04,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x08,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x0C,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x10,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x14,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x18,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x01,},
+  {.address = 0x09, .data = 0x1C,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x1F,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x02, .data = 0x31,},
+  {.address = 0x08, .data = 0x8E,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x55,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x01, .data = 0x00,},
+  {.address = 0x01, .data = 0x80,},
+  {.address = 0x17, .data = 0x40,},
+  {.address = 0x02, .data = 0x31,},
+  {.address = 0x08, .data = 0x9A,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x00,},
+  {.address = 0x09, .data = 0x04,},
+  {.address = 0x09, .data = 0xE0,},
+  {.address = 0x01, .data = 0x80,},
+  {.address = 0x17, .data = 0x00,},
+  {.address = 0x04, .data = 0x00,},
+  {.address = 0x05, .data = 0x10,},
+  {.address = 0x02, .data = 0x01,},
+  {.address = 0x01, .data = 0x00,},
+  {.address = 0x5E, .data = 0x02,},
+  {.address = 0x01, .data = 0x80,},
+  {.address = 0x0D, .data = 0x01,},
+  {.address = 0x60, .data = 0x15,},
+  {.address = 0x01, .data = 0x00,},
+  {.address = 0x10, .data = 0x20,},
+  {.address = 0x11, .data = 0x00,}
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOVEMENT_H */
+
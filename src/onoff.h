@@ -32,8 +32,17 @@ typedef struct {
 
 #endif /* MEMS_UCF_SHARED_TYPES */
 
+#ifndef MEMS_UCF_TABLE
+/* constexpr in C++ so ucf_packed.h can validate and pack the table at build time */
+#ifdef __cplusplus
+#define MEMS_UCF_TABLE constexpr
+#else
+#define MEMS_UCF_TABLE const
+#endif
+#endif /* MEMS_UCF_TABLE */
+
 /** Configuration array generated from Unico Tool **/
-const ucf_line_t onoff[] = {
+MEMS_UCF_TABLE ucf_line_t onoff[] = {
   {.address = 0x10, .data = 0x00,},
   {.address = 0x11, .data = 0x00,},
   {.address = 0x01, .data = 0x80,},
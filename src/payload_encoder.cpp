@@ -0,0 +1,175 @@
+#include "payload_encoder.h"
+
+// constexpr: built at compile time, before any constructor that may register them
+constexpr Float32PayloadEncoder float32Payload;
+constexpr Int16PayloadEncoder int16Payload;
+constexpr Int16SixAxisPayloadEncoder int16SixAxisPayload;
+constexpr DeltaVarintPayloadEncoder deltaVarintPayload(PAYLOAD_FORMAT_DELTA_VARINT, false);
+constexpr DeltaVarintPayloadEncoder deltaVarintPlanarPayload(PAYLOAD_FORMAT_DELTA_VARINT_PLANAR, true);
+
+// float32 ax,ay,az interleaved per sample
+
+bool Float32PayloadEncoder::accepts(const PayloadSource& src) const {
+    return src.axes == 3 && src.mg[0] != nullptr;
+}
+
+int Float32PayloadEncoder::encodedSize(const PayloadSource&, int, int count) const {
+    return count * 12;
+}
+
+void Float32PayloadEncoder::encode(const PayloadSource& src, int first, int count, ByteSink& out) const {
+    for (int i = first; i < first + count; i++) {
+        out.write(&src.mg[0][i], 4);
+        out.write(&src.mg[1][i], 4);
+        out.write(&src.mg[2][i], 4);
+    }
+}
+
+// int16 ax,ay,az interleaved per sample
+
+bool Int16PayloadEncoder::accepts(const PayloadSource& src) const {
+    return src.axes == 3 && src.raw[0] != nullptr;
+}
+
+int Int16PayloadEncoder::encodedSize(const PayloadSource&, int, int count) const {
+    return count * 6;
+}
+
+void Int16PayloadEncoder::encode(const PayloadSource& src, int first, int count, ByteSink& out) const {
+    for (int i = first; i < first + count; i++) {
+        out.write(&src.raw[0][i], 2);
+        out.write(&src.raw[1][i], 2);
+        out.write(&src.raw[2][i], 2);
+    }
+}
+
+// int16 ax,ay,az,gx,gy,gz interleaved per sample
+
+bool Int16SixAxisPayloadEncoder::accepts(const PayloadSource& src) const {
+    return src.axes == 6 && src.raw[0] != nullptr;
+}
+
+int Int16SixAxisPayloadEncoder::encodedSize(const PayloadSource&, int, int count) const {
+    return count * 12;
+}
+
+void Int16SixAxisPayloadEncoder::encode(const PayloadSource& src, int first, int count, ByteSink& out) const {
+    for (int i = first; i < first + count; i++) {
+        for (int axis = 0; axis < 6; axis++) {
+            out.write(&src.raw[axis][i], 2);
+        }
+    }
+}
+
+// Raw counts as zigzag varint deltas
+
+// Zigzag keeps small negative steps small: 0, -1, 1, -2, 2 ... map to 0, 1, 2, 3, 4 ...
+static int writeDelta(int32_t delta, ByteSink* out) {
+    uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    int bytes = 0;
+
+    do {
+        uint8_t group = value & 0x7F;
+        value >>= 7;
+        if (value != 0) {
+            group |= 0x80;
+        }
+        if (out != nullptr) {
+            out->write(&group, 1);
+        }
+        bytes++;
+    } while (value != 0);
+
+    return bytes;
+}
+
+bool DeltaVarintPayloadEncoder::accepts(const PayloadSource& src) const {
+    return src.raw[0] != nullptr;
+}
+
+int DeltaVarintPayloadEncoder::encodedSize(const PayloadSource& src, int first, int count) const {
+    return run(src, first, count, nullptr);
+}
+
+void DeltaVarintPayloadEncoder::encode(const PayloadSource& src, int first, int count, ByteSink& out) const {
+    run(src, first, count, &out);
+}
+
+int DeltaVarintPayloadEncoder::run(const PayloadSource& src, int first, int count, ByteSink* out) const {
+    if (count <= 0) {
+        return 0;
+    }
+
+    int bytes = 0;
+
+    if (planar) {
+        for (int axis = 0; axis < src.axes; axis++) {
+            const int16_t* values = src.raw[axis];
+            if (out != nullptr) {
+                out->write(&values[first], 2);
+            }
+            bytes += 2;
+            for (int i = first + 1; i < first + count; i++) {
+                bytes += writeDelta((int32_t)values[i] - values[i - 1], out);
+            }
+        }
+        return bytes;
+    }
+
+    for (int axis = 0; axis < src.axes; axis++) {
+        if (out != nullptr) {
+            out->write(&src.raw[axis][first], 2);
+        }
+        bytes += 2;
+    }
+    for (int i = first + 1; i < first + count; i++) {
+        for (int axis = 0; axis < src.axes; axis++) {
+            bytes += writeDelta((int32_t)src.raw[axis][i] - src.raw[axis][i - 1], out);
+        }
+    }
+    return bytes;
+}
+
+PayloadRegistry::PayloadRegistry() : encoderCount(0) {
+    memset(encoders, 0, sizeof(encoders));
+}
+
+int PayloadRegistry::registerEncoder(const PayloadEncoder* encoder) {
+    if (encoder == nullptr || encoderCount >= PAYLOAD_MAX_ENCODERS) {
+        return -1;
+    }
+
+    if (encoder->format() == PAYLOAD_FORMAT_AUTO || find(encoder->format()) != nullptr) {
+        return -1;
+    }
+
+    encoders[encoderCount] = encoder;
+    return encoderCount++;
+}
+
+const PayloadEncoder* PayloadRegistry::find(uint8_t format) {
+    for (int i = 0; i < encoderCount; i++) {
+        if (encoders[i]->format() == format) {
+            return encoders[i];
+        }
+    }
+    return nullptr;
+}
+
+const PayloadEncoder* PayloadRegistry::select(uint8_t format, const PayloadSource& src) {
+    const PayloadEncoder* preferred = find(format);
+    if (preferred != nullptr && preferred->accepts(src)) {
+        return preferred;
+    }
+
+    for (int i = 0; i < encoderCount; i++) {
+        if (encoders[i]->accepts(src)) {
+            return encoders[i];
+        }
+    }
+    return nullptr;
+}
+
+int PayloadRegistry::getCount() {
+    return encoderCount;
+}
@@ -0,0 +1,126 @@
+#ifndef PAYLOAD_ENCODER_H
+#define PAYLOAD_ENCODER_H
+
+#include <Arduino.h>
+#include "b64_stream.h"
+
+// sensors.qo wire formats. Every note carries "format" and "codec" (the layout
+// version of that format) so the backend can pick the matching decoder.
+// 2 is skipped: data.qo state logs are "Format 2".
+#define PAYLOAD_FORMAT_AUTO 0         // the capture profile's choice, else the first that fits
+#define PAYLOAD_FORMAT_FLOAT32 1      // float32 ax,ay,az per sample in mg
+#define PAYLOAD_FORMAT_INT16 3        // int16 ax,ay,az per sample in raw LSB, body "scale" = mg/LSB
+#define PAYLOAD_FORMAT_INT16_6AXIS 4  // int16 ax,ay,az,gx,gy,gz per sample, "scale" = mg/LSB, "gyro_scale" = mdps/LSB
+#define PAYLOAD_FORMAT_DELTA_VARINT 5         // raw counts as zigzag varint deltas, axes interleaved per sample
+#define PAYLOAD_FORMAT_DELTA_VARINT_PLANAR 6  // same, one axis block after the other
+
+#define PAYLOAD_MAX_ENCODERS 8
+
+// The capture as an encoder sees it: planar axis arrays, either raw counts or mg
+struct PayloadSource {
+    int axes;                // 3 for accel, 6 with gyro
+    const int16_t* raw[6];   // raw counts per axis, null for float captures
+    const float* mg[3];      // mg per axis, null for raw captures
+};
+
+// Encoders are constant-initialized globals that nothing deletes, so the base keeps a
+// trivial destructor and every concrete encoder has a constexpr constructor
+class PayloadEncoder {
+protected:
+    ~PayloadEncoder() = default;
+
+public:
+    virtual uint8_t format() const = 0;
+    virtual uint8_t codec() const = 0;
+    virtual const char* name() const = 0;
+
+    // Whether this format can carry the capture at all
+    virtual bool accepts(const PayloadSource& src) const = 0;
+
+    // Exact byte count encode() writes for the range, before base64
+    virtual int encodedSize(const PayloadSource& src, int first, int count) const = 0;
+    virtual void encode(const PayloadSource& src, int first, int count, ByteSink& out) const = 0;
+};
+
+class Float32PayloadEncoder : public PayloadEncoder {
+public:
+    uint8_t format() const { return PAYLOAD_FORMAT_FLOAT32; }
+    uint8_t codec() const { return 1; }
+    const char* name() const { return "float32"; }
+    bool accepts(const PayloadSource& src) const;
+    int encodedSize(const PayloadSource& src, int first, int count) const;
+    void encode(const PayloadSource& src, int first, int count, ByteSink& out) const;
+};
+
+class Int16PayloadEncoder : public PayloadEncoder {
+public:
+    uint8_t format() const { return PAYLOAD_FORMAT_INT16; }
+    uint8_t codec() const { return 1; }
+    const char* name() const { return "int16"; }
+    bool accepts(const PayloadSource& src) const;
+    int encodedSize(const PayloadSource& src, int first, int count) const;
+    void encode(const PayloadSource& src, int first, int count, ByteSink& out) const;
+};
+
+class Int16SixAxisPayloadEncoder : public PayloadEncoder {
+public:
+    uint8_t format() const { return PAYLOAD_FORMAT_INT16_6AXIS; }
+    uint8_t codec() const { return 1; }
+    const char* name() const { return "int16_6axis"; }
+    bool accepts(const PayloadSource& src) const;
+    int encodedSize(const PayloadSource& src, int first, int count) const;
+    void encode(const PayloadSource& src, int first, int count, ByteSink& out) const;
+};
+
+// Raw counts (3 or 6 axes) as deltas: the note's first sample goes out as int16 per
+// axis, every later value as the zigzag-mapped difference from the previous value
+// of the same axis in LEB128 varint bytes (7 bits each, low group first, high bit =
+// more). Each note restarts from a raw sample, so chunks decode on their own.
+// Slow 26 Hz signals mostly move by a few LSB, which fits in one byte.
+class DeltaVarintPayloadEncoder : public PayloadEncoder {
+private:
+    uint8_t formatId;
+    bool planar;
+
+    // Walks the range once; writes when out is set and returns the byte count either way
+    int run(const PayloadSource& src, int first, int count, ByteSink* out) const;
+
+public:
+    constexpr DeltaVarintPayloadEncoder(uint8_t id, bool planarLayout)
+        : formatId(id), planar(planarLayout) {}
+
+    uint8_t format() const { return formatId; }
+    uint8_t codec() const { return 1; }
+    const char* name() const { return planar ? "delta_varint_planar" : "delta_varint"; }
+    bool accepts(const PayloadSource& src) const;
+    int encodedSize(const PayloadSource& src, int first, int count) const;
+    void encode(const PayloadSource& src, int first, int count, ByteSink& out) const;
+};
+
+extern const Float32PayloadEncoder float32Payload;
+extern const Int16PayloadEncoder int16Payload;
+extern const Int16SixAxisPayloadEncoder int16SixAxisPayload;
+extern const DeltaVarintPayloadEncoder deltaVarintPayload;
+extern const DeltaVarintPayloadEncoder deltaVarintPlanarPayload;
+
+// Registered wire formats; registration order is the fallback order for PAYLOAD_FORMAT_AUTO
+class PayloadRegistry {
+private:
+    const PayloadEncoder* encoders[PAYLOAD_MAX_ENCODERS];
+    int encoderCount;
+
+public:
+    PayloadRegistry();
+
+    // Returns the encoder index, or -1 when the registry is full or the format is taken
+    int registerEncoder(const PayloadEncoder* encoder);
+
+    const PayloadEncoder* find(uint8_t format);
+
+    // The requested format if it accepts the capture, else the first registered one that does
+    const PayloadEncoder* select(uint8_t format, const PayloadSource& src);
+
+    int getCount();
+};
+
+#endif // PAYLOAD_ENCODER_H
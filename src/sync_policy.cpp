@@ -0,0 +1,112 @@
+#include "sync_policy.h"
+
+SyncPolicy::SyncPolicy() : notecard(nullptr), maxBytes(SYNC_DEFAULT_MAX_BYTES),
+    maxAgeS(SYNC_DEFAULT_MAX_AGE_S), syncPriority(SYNC_DEFAULT_PRIORITY), oldestEpoch(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void SyncPolicy::begin(Notecard* nc) {
+    notecard = nc;
+}
+
+void SyncPolicy::setThresholds(unsigned long bytes, unsigned long ageSeconds, NotePriority priority) {
+    maxBytes = bytes;
+    maxAgeS = ageSeconds;
+    syncPriority = priority;
+}
+
+bool SyncPolicy::noteAdded(unsigned long bytes, NotePriority priority, unsigned long epoch) {
+    stats.notes++;
+    stats.queuedNotes++;
+    stats.queuedBytes += bytes;
+    if (oldestEpoch == 0) {
+        oldestEpoch = epoch;
+    }
+
+    if (priority >= syncPriority) {
+        return syncNow();
+    }
+    if (maxBytes > 0 && stats.queuedBytes >= maxBytes) {
+        return thresholdSync(epoch);
+    }
+    return poll(epoch);
+}
+
+bool SyncPolicy::poll(unsigned long epoch) {
+    if (stats.queuedNotes == 0 || maxAgeS == 0 || oldestEpoch == 0) {
+        return false;
+    }
+
+    if (epoch >= oldestEpoch && epoch - oldestEpoch >= maxAgeS) {
+        return thresholdSync(epoch);
+    }
+    return false;
+}
+
+bool SyncPolicy::refreshQueue(unsigned long epoch) {
+    if (notecard == nullptr) {
+        return true;
+    }
+
+    J *req = notecard->newRequest("file.changes.pending");
+    if (req == NULL) {
+        return true;
+    }
+    J *rsp = notecard->requestAndResponse(req);
+    if (rsp == NULL) {
+        return true;
+    }
+    bool valid = !notecard->responseError(rsp);
+    unsigned long pending = JGetBool(rsp, "pending") ? (unsigned long)JGetInt(rsp, "total") : 0;
+    notecard->deleteResponse(rsp);
+    if (!valid) {
+        return true;
+    }
+
+    // The count covers notes from outside the policy too (e.g. _track.qo), so it
+    // only ever lowers the queue. The bytes shrink in proportion, and the notes
+    // left were queued after that session, so their age restarts from now.
+    if (pending < stats.queuedNotes) {
+        stats.avoided += stats.queuedNotes - pending;
+        stats.queuedBytes = pending > 0 ? stats.queuedBytes / stats.queuedNotes * pending : 0;
+        stats.queuedNotes = pending;
+        oldestEpoch = epoch;
+    }
+    if (stats.queuedNotes == 0) {
+        oldestEpoch = 0;
+        return false;
+    }
+    return true;
+}
+
+bool SyncPolicy::thresholdSync(unsigned long epoch) {
+    if (!refreshQueue(epoch)) {
+        return false;
+    }
+    return syncNow();
+}
+
+bool SyncPolicy::syncNow() {
+    if (notecard == nullptr) {
+        return false;
+    }
+
+    J *req = notecard->newRequest("hub.sync");
+    if (req == NULL || !notecard->sendRequest(req)) {
+        return false;
+    }
+
+    // One session for the whole queue instead of one per note
+    stats.syncs++;
+    if (stats.queuedNotes > 1) {
+        stats.avoided += stats.queuedNotes - 1;
+    }
+    stats.queuedNotes = 0;
+    stats.queuedBytes = 0;
+    oldestEpoch = 0;
+    return true;
+}
+
+const SyncStats& SyncPolicy::getStats() {
+    return stats;
+}
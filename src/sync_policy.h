@@ -0,0 +1,65 @@
+#ifndef SYNC_POLICY_H
+#define SYNC_POLICY_H
+
+#include <Arduino.h>
+#include <Notecard.h>
+
+// Batching sync policy: note.add requests go out without "sync", and one hub.sync
+// is requested only when the queued notes cross a threshold. Between those the
+// Notecard's own hub.set outbound schedule carries them, so a cycle's notes share
+// one modem session instead of starting one each. Before a threshold sync the
+// Notecard's pending-note count is checked, so notes a scheduled session already
+// carried do not trigger another one.
+
+enum NotePriority {
+    NOTE_PRIORITY_BULK = 0,    // captures: wait for the byte or age threshold
+    NOTE_PRIORITY_NORMAL = 1,  // state events
+    NOTE_PRIORITY_URGENT = 2   // e.g. MLC transition waveforms
+};
+
+#define SYNC_DEFAULT_MAX_BYTES (48 * 1024UL)  // queued payload bytes
+#define SYNC_DEFAULT_MAX_AGE_S (4 * 3600UL)   // age of the oldest queued note
+#define SYNC_DEFAULT_PRIORITY NOTE_PRIORITY_URGENT
+
+struct SyncStats {
+    unsigned long notes;         // notes queued through the policy
+    unsigned long syncs;         // hub.sync requests it made
+    unsigned long avoided;       // per-note sessions the policy kept from starting
+    unsigned long queuedBytes;   // since the last hub.sync
+    unsigned long queuedNotes;
+};
+
+class SyncPolicy {
+private:
+    Notecard* notecard;
+    unsigned long maxBytes;
+    unsigned long maxAgeS;
+    NotePriority syncPriority;
+
+    unsigned long oldestEpoch;   // RTC time of the oldest note since the last sync, 0 if none
+    SyncStats stats;
+
+    // Drop what the outbound schedule already sent; false if nothing is left queued
+    bool refreshQueue(unsigned long epoch);
+    bool thresholdSync(unsigned long epoch);
+
+public:
+    SyncPolicy();
+
+    void begin(Notecard* nc);
+
+    // A note at or above priority syncs right away; 0 disables the byte or age threshold
+    void setThresholds(unsigned long bytes, unsigned long ageSeconds, NotePriority priority);
+
+    // Account for a note.add that went out without "sync"; bytes is roughly what
+    // it costs on the air, epoch the current RTC time. Returns true if it synced.
+    bool noteAdded(unsigned long bytes, NotePriority priority, unsigned long epoch);
+
+    // Age check for cycles that add no notes; returns true if it synced
+    bool poll(unsigned long epoch);
+
+    bool syncNow();
+    const SyncStats& getStats();
+};
+
+#endif // SYNC_POLICY_H
@@ -0,0 +1,374 @@
+#include "ucf_loader.h"
+#include "ucf_packed.h"
+
+// PAGE_RW values for read-back
+#define UCF_PAGE_RW_OFF 0x00
+#define UCF_PAGE_RW_READ 0x20
+
+// CTRL3_C register address auto-increment
+#define UCF_CTRL3_IF_INC 0x04
+
+// EMB_FUNC_INIT_B machine learning core reset request
+#define UCF_EMB_FUNC_INIT_MLC 0x10
+
+// EMB_FUNC_EN_B bits the driver sets at runtime (FSM_EN from Enable_FSM(),
+// FIFO_COMPR_EN for compressed captures); the program's value is not expected there
+#define UCF_EMB_FUNC_EN_B_RUNTIME 0x09
+
+// What a UCF line does once the bank and page registers are accounted for
+enum UcfItem {
+    UCF_ITEM_PAGE_BYTE,   // byte written through PAGE_VALUE at (page << 8 | address)
+    UCF_ITEM_EMB_REG,     // plain embedded-bank register write
+    UCF_ITEM_USER_REG     // user-bank register write
+};
+
+typedef bool (*UcfVisitor)(UcfItem item, uint16_t addr, uint8_t value, void* context);
+
+// Replays the program's bank and page bookkeeping without touching the bus
+static bool walkProgram(const UcfProgram& program, UcfVisitor visit, void* context) {
+    uint8_t bank = UCF_BANK_USER;
+    uint8_t page = 0;
+    uint8_t pageAddr = 0;
+    uint16_t i = 0;
+    uint8_t reg = 0;
+    uint8_t remaining = 0;
+
+    while (i < program.size) {
+        // Unpack one write at a time: record header, or the next byte of a run
+        if (remaining == 0) {
+            uint8_t head = program.data[i++];
+            reg = head & ~UCF_PACKED_RUN;
+            remaining = (head & UCF_PACKED_RUN) ? program.data[i++] : 1;
+        }
+        uint8_t value = program.data[i++];
+        remaining--;
+
+        if (reg == LSM6DSOX_FUNC_CFG_ACCESS) {
+            bank = value;
+            continue;
+        }
+
+        if (bank != UCF_BANK_EMBEDDED) {
+            if (!visit(UCF_ITEM_USER_REG, reg, value, context)) {
+                return false;
+            }
+            continue;
+        }
+
+        switch (reg) {
+            case LSM6DSOX_PAGE_RW:
+                break;
+            case LSM6DSOX_PAGE_SEL:
+                page = value >> 4;
+                break;
+            case LSM6DSOX_PAGE_ADDRESS:
+                pageAddr = value;
+                break;
+            case LSM6DSOX_PAGE_VALUE:
+                if (!visit(UCF_ITEM_PAGE_BYTE, ((uint16_t)page << 8) | pageAddr, value, context)) {
+                    return false;
+                }
+                // PAGE_ADDRESS auto-increments and wraps into the next page
+                pageAddr++;
+                if (pageAddr == 0) {
+                    page++;
+                }
+                break;
+            default:
+                if (!visit(UCF_ITEM_EMB_REG, reg, value, context)) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
+
+// CRC-16/CCITT-FALSE, fed one byte at a time
+static uint16_t crcUpdate(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+// Final value of every embedded register the program writes (last write wins)
+struct EmbeddedRegs {
+    uint8_t value[128];
+    uint8_t written[16];
+};
+
+static bool isWritten(const EmbeddedRegs& regs, uint8_t reg) {
+    return (regs.written[reg >> 3] & (1 << (reg & 7))) != 0;
+}
+
+static bool collectEmbeddedReg(UcfItem item, uint16_t addr, uint8_t value, void* context) {
+    EmbeddedRegs* regs = (EmbeddedRegs*)context;
+    if (item == UCF_ITEM_EMB_REG && addr < 128) {
+        regs->value[addr] = value;
+        regs->written[addr >> 3] |= (uint8_t)(1 << (addr & 7));
+    }
+    return true;
+}
+
+static void collectEmbeddedRegs(const UcfProgram& program, EmbeddedRegs* regs) {
+    memset(regs, 0, sizeof(*regs));
+    walkProgram(program, collectEmbeddedReg, regs);
+}
+
+static bool checksumPageByte(UcfItem item, uint16_t addr, uint8_t value, void* context) {
+    uint16_t* crc = (uint16_t*)context;
+    if (item == UCF_ITEM_PAGE_BYTE) {
+        *crc = crcUpdate(*crc, addr >> 8);
+        *crc = crcUpdate(*crc, addr & 0xFF);
+        *crc = crcUpdate(*crc, value);
+    }
+    return true;
+}
+
+static uint16_t checksumRegs(uint16_t crc, const EmbeddedRegs& regs) {
+    for (int reg = 0; reg < 128; reg++) {
+        if (isWritten(regs, reg)) {
+            crc = crcUpdate(crc, reg);
+            crc = crcUpdate(crc, regs.value[reg]);
+        }
+    }
+    return crc;
+}
+
+uint16_t ucfChecksum(const UcfProgram& program) {
+    uint16_t crc = 0xFFFF;
+    walkProgram(program, checksumPageByte, &crc);
+
+    EmbeddedRegs regs;
+    collectEmbeddedRegs(program, &regs);
+    return checksumRegs(crc, regs);
+}
+
+// Address window tested by ucfPagesOverlap(); the walk stops at the first hit
+struct PageWindow {
+    uint16_t first;
+    uint16_t len;
+    bool hit;
+};
+
+static bool checkPageWindow(UcfItem item, uint16_t addr, uint8_t, void* context) {
+    PageWindow* window = (PageWindow*)context;
+    if (item == UCF_ITEM_PAGE_BYTE && (uint16_t)(addr - window->first) < window->len) {
+        window->hit = true;
+        return false;
+    }
+    return true;
+}
+
+bool ucfPagesOverlap(const UcfProgram& program, uint16_t first, uint16_t len) {
+    PageWindow window = { first, len, false };
+    walkProgram(program, checkPageWindow, &window);
+    return window.hit;
+}
+
+// Read-back state shared by the signature and verify walks
+struct PageReader {
+    LSM6DSOXSensor* sensor;
+    int index;        // page byte index in program order
+    int stride;       // read every stride-th byte
+    uint16_t crc;     // checksum of the bytes read back
+    bool match;       // every sampled byte matched the table
+    bool ok;          // no bus error
+};
+
+static bool readPageByte(UcfItem item, uint16_t addr, uint8_t value, void* context) {
+    PageReader* reader = (PageReader*)context;
+    if (item != UCF_ITEM_PAGE_BYTE) {
+        return true;
+    }
+
+    int index = reader->index++;
+    if (index % reader->stride != 0) {
+        return true;
+    }
+
+    uint8_t actual = 0;
+    if (reader->sensor->Write_Reg(LSM6DSOX_PAGE_SEL, (uint8_t)(((addr >> 8) << 4) | 0x01)) != LSM6DSOX_OK ||
+        reader->sensor->Write_Reg(LSM6DSOX_PAGE_ADDRESS, addr & 0xFF) != LSM6DSOX_OK ||
+        reader->sensor->Read_Reg(LSM6DSOX_PAGE_VALUE, &actual) != LSM6DSOX_OK) {
+        reader->ok = false;
+        return false;
+    }
+
+    reader->crc = crcUpdate(reader->crc, addr >> 8);
+    reader->crc = crcUpdate(reader->crc, addr & 0xFF);
+    reader->crc = crcUpdate(reader->crc, actual);
+
+    if (actual != value) {
+        reader->match = false;
+    }
+
+    // The signature check can stop at the first difference; verify reads everything
+    return reader->match || reader->stride == 1;
+}
+
+// Reads back embedded registers and page bytes; leaves the sensor in the user bank
+static bool readBack(LSM6DSOXSensor& sensor, const UcfProgram& program, int stride, uint16_t* crc) {
+    EmbeddedRegs regs;
+    collectEmbeddedRegs(program, &regs);
+
+    PageReader reader = { &sensor, 0, stride, 0xFFFF, true, true };
+
+    if (sensor.Write_Reg(LSM6DSOX_FUNC_CFG_ACCESS, UCF_BANK_EMBEDDED) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (sensor.Write_Reg(LSM6DSOX_PAGE_RW, UCF_PAGE_RW_READ) == LSM6DSOX_OK) {
+        walkProgram(program, readPageByte, &reader);
+    } else {
+        reader.ok = false;
+    }
+
+    sensor.Write_Reg(LSM6DSOX_PAGE_RW, UCF_PAGE_RW_OFF);
+    sensor.Write_Reg(LSM6DSOX_PAGE_SEL, 0x01);
+
+    // Embedded registers are compared by value and folded into the checksum,
+    // runtime-owned bits taken from the program
+    EmbeddedRegs actual = regs;
+    for (int reg = 0; reg < 128 && reader.ok && reader.match; reg++) {
+        if (!isWritten(regs, reg)) {
+            continue;
+        }
+        if (sensor.Read_Reg(reg, &actual.value[reg]) != LSM6DSOX_OK) {
+            reader.ok = false;
+            continue;
+        }
+        if (reg == LSM6DSOX_EMB_FUNC_EN_B) {
+            actual.value[reg] = (uint8_t)((actual.value[reg] & ~UCF_EMB_FUNC_EN_B_RUNTIME) |
+                                          (regs.value[reg] & UCF_EMB_FUNC_EN_B_RUNTIME));
+        }
+        if (actual.value[reg] != regs.value[reg]) {
+            reader.match = false;
+        }
+    }
+
+    sensor.Write_Reg(LSM6DSOX_FUNC_CFG_ACCESS, UCF_BANK_USER);
+
+    *crc = checksumRegs(reader.crc, actual);
+    return reader.ok && reader.match;
+}
+
+bool ucfSignatureMatches(LSM6DSOXSensor& sensor, const UcfProgram& program) {
+    uint16_t crc;
+    return readBack(sensor, program, UCF_SIGNATURE_STRIDE, &crc);
+}
+
+bool ucfVerify(LSM6DSOXSensor& sensor, const UcfProgram& program) {
+    uint16_t crc;
+    if (!readBack(sensor, program, 1, &crc)) {
+        return false;
+    }
+    return crc == ucfChecksum(program);
+}
+
+// Streams the packed records that fall in scope; bank switches are always kept
+static bool writeProgram(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfScope scope, int* writes) {
+    uint8_t bank = UCF_BANK_USER;
+    uint16_t i = 0;
+
+    while (i < program.size) {
+        uint8_t head = program.data[i++];
+        uint8_t reg = head & ~UCF_PACKED_RUN;
+        uint8_t n = (head & UCF_PACKED_RUN) ? program.data[i++] : 1;
+        const uint8_t* values = &program.data[i];
+        i += n;
+
+        if (reg == LSM6DSOX_FUNC_CFG_ACCESS) {
+            bank = values[0];
+            if (scope == UCF_SCOPE_USER) {
+                continue;
+            }
+        } else if (scope == UCF_SCOPE_USER && bank == UCF_BANK_EMBEDDED) {
+            continue;
+        } else if (scope == UCF_SCOPE_EMBEDDED && bank != UCF_BANK_EMBEDDED) {
+            continue;
+        }
+
+        // With IF_INC cleared every byte of a run lands on PAGE_VALUE
+        LSM6DSOXStatusTypeDef status = (n == 1) ? sensor.Write_Reg(reg, values[0])
+                                                : sensor.Write_Reg_Burst(reg, values, n);
+        if (status != LSM6DSOX_OK) {
+            return false;
+        }
+        (*writes)++;
+    }
+
+    return true;
+}
+
+// writeProgram() with IF_INC cleared so PAGE_VALUE runs can be bursts
+static bool writeProgramBursts(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfScope scope, int* writes) {
+    uint8_t ctrl3 = 0;
+    if (sensor.Read_Reg(LSM6DSOX_CTRL3_C, &ctrl3) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    if (sensor.Write_Reg(LSM6DSOX_CTRL3_C, ctrl3 & ~UCF_CTRL3_IF_INC) != LSM6DSOX_OK) {
+        return false;
+    }
+
+    bool written = writeProgram(sensor, program, scope, writes);
+
+    // A failed load may have stopped in the embedded bank, where CTRL3_C is not mapped
+    if (!written) {
+        sensor.Write_Reg(LSM6DSOX_FUNC_CFG_ACCESS, UCF_BANK_USER);
+    }
+    sensor.Write_Reg(LSM6DSOX_CTRL3_C, ctrl3);
+
+    return written;
+}
+
+bool ucfLoad(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfLoadReport* report) {
+    unsigned long start = micros();
+
+    report->skipped = false;
+    report->verified = false;
+    report->checksum = ucfChecksum(program);
+    report->writes = 0;
+
+    if (ucfSignatureMatches(sensor, program)) {
+        // Same program already running (MCU-only reset or DFU): restore the user-bank side
+        report->skipped = true;
+        report->verified = writeProgram(sensor, program, UCF_SCOPE_USER, &report->writes);
+        report->durationUs = micros() - start;
+        return report->verified;
+    }
+
+    bool written = writeProgramBursts(sensor, program, UCF_SCOPE_ALL, &report->writes);
+
+    report->verified = written && ucfVerify(sensor, program);
+    report->durationUs = micros() - start;
+    return report->verified;
+}
+
+bool ucfLoadEmbedded(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfLoadReport* report) {
+    unsigned long start = micros();
+
+    report->skipped = false;
+    report->verified = false;
+    report->checksum = ucfChecksum(program);
+    report->writes = 0;
+
+    bool written = writeProgramBursts(sensor, program, UCF_SCOPE_EMBEDDED, &report->writes);
+
+    // Restart the MLC so the new trees do not start from the old model's state
+    if (written) {
+        written = sensor.Write_Reg(LSM6DSOX_FUNC_CFG_ACCESS, UCF_BANK_EMBEDDED) == LSM6DSOX_OK &&
+                  sensor.Write_Reg(LSM6DSOX_EMB_FUNC_INIT_B, UCF_EMB_FUNC_INIT_MLC) == LSM6DSOX_OK;
+        sensor.Write_Reg(LSM6DSOX_FUNC_CFG_ACCESS, UCF_BANK_USER);
+        report->writes += 3;
+    }
+
+    // A swap happens at runtime, so the cheap signature check stands in for a full read-back
+    report->verified = written && ucfSignatureMatches(sensor, program);
+    report->durationUs = micros() - start;
+    return report->verified;
+}
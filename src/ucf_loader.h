@@ -0,0 +1,49 @@
+#ifndef UCF_LOADER_H
+#define UCF_LOADER_H
+
+#include <Arduino.h>
+#include "LSM6DSOXSensor.h"
+#include "ucf_programs.h"
+
+// Every Nth program page byte is read back to decide whether a reload is needed
+#define UCF_SIGNATURE_STRIDE 8
+
+// Which part of a program a load writes
+enum UcfScope {
+    UCF_SCOPE_ALL = 0,       // every line
+    UCF_SCOPE_USER = 1,      // user-bank lines only (ODR, interrupt routing)
+    UCF_SCOPE_EMBEDDED = 2   // embedded-bank lines only (MLC pages and registers)
+};
+
+// Outcome of the last ucfLoad() or ucfLoadEmbedded()
+struct UcfLoadReport {
+    bool skipped;               // sensor already ran the program, only user-bank lines replayed
+    bool verified;              // read-back matched: sampled signature when skipped, full checksum when loaded
+    uint16_t checksum;          // expected checksum of the embedded-bank program
+    int writes;                 // bus write transactions issued (a PAGE_VALUE run is one)
+    unsigned long durationUs;   // load time, including signature check and verification
+};
+
+// Load a packed UCF program unless the sensor already runs it. The embedded-bank
+// part (MLC pages and embedded registers) is skipped when the read-back
+// signature matches; user-bank lines (ODR, interrupt routing) are always replayed.
+// PAGE_VALUE runs are streamed in one write each with IF_INC cleared.
+bool ucfLoad(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfLoadReport* report);
+
+// Swap the embedded-bank part only, for programs sharing the running user-bank
+// setup (ODR, full scale, INT routing); the MLC is re-initialized afterwards
+bool ucfLoadEmbedded(LSM6DSOXSensor& sensor, const UcfProgram& program, UcfLoadReport* report);
+
+// Checksum over the program's page bytes and final embedded-register values
+uint16_t ucfChecksum(const UcfProgram& program);
+
+// True when the program writes any page byte in [first, first + len)
+bool ucfPagesOverlap(const UcfProgram& program, uint16_t first, uint16_t len);
+
+// Cheap check: embedded registers plus every UCF_SIGNATURE_STRIDE-th page byte
+bool ucfSignatureMatches(LSM6DSOXSensor& sensor, const UcfProgram& program);
+
+// Full check: reads every page byte back and compares checksums
+bool ucfVerify(LSM6DSOXSensor& sensor, const UcfProgram& program);
+
+#endif // UCF_LOADER_H
@@ -0,0 +1,173 @@
+#ifndef UCF_PACKED_H
+#define UCF_PACKED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEMS_UCF_SHARED_TYPES
+#define MEMS_UCF_SHARED_TYPES
+
+/** Common data block definition **/
+typedef struct {
+  uint8_t address;
+  uint8_t data;
+} ucf_line_t;
+
+#endif /* MEMS_UCF_SHARED_TYPES */
+
+// Compile-time validation and run-length packing of Unico UCF tables.
+//
+// Packed form, one record after another:
+//   reg, value                  single write (reg < 0x80)
+//   0x80 | reg, n, v1 .. vn     n consecutive writes to PAGE_VALUE
+// Register addresses are 7-bit, so bit 7 of the first byte marks a run.
+// A PAGE_VALUE run can be streamed in one I2C write with IF_INC cleared.
+
+#define UCF_PACKED_RUN 0x80
+#define UCF_PACKED_MAX_RUN 255
+
+// Registers the packer and validator need (same values as lsm6dsox_reg.h)
+#define UCF_REG_FUNC_CFG_ACCESS 0x01
+#define UCF_REG_PAGE_SEL 0x02
+#define UCF_REG_PAGE_ADDRESS 0x08
+#define UCF_REG_PAGE_VALUE 0x09
+#define UCF_REG_PAGE_RW 0x17
+
+// FUNC_CFG_ACCESS and PAGE_RW values
+#define UCF_BANK_USER 0x00
+#define UCF_BANK_SENSOR_HUB 0x40
+#define UCF_BANK_EMBEDDED 0x80
+#define UCF_PAGE_RW_WRITE 0x40
+
+// Every address fits the 7-bit packed record header
+template <size_t N>
+constexpr bool ucfAddressesValid(const ucf_line_t (&lines)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (lines[i].address & UCF_PACKED_RUN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Bank switches use known values and the program hands back the user bank
+template <size_t N>
+constexpr bool ucfBanksValid(const ucf_line_t (&lines)[N]) {
+    uint8_t bank = UCF_BANK_USER;
+    for (size_t i = 0; i < N; i++) {
+        if (lines[i].address == UCF_REG_FUNC_CFG_ACCESS) {
+            bank = lines[i].data;
+            if (bank != UCF_BANK_USER && bank != UCF_BANK_SENSOR_HUB && bank != UCF_BANK_EMBEDDED) {
+                return false;
+            }
+        }
+    }
+    return bank == UCF_BANK_USER;
+}
+
+// Page registers are only touched in the embedded bank, PAGE_SEL keeps its
+// reserved bit 0 set, and PAGE_VALUE is only written once writes are enabled
+// and an address was selected
+template <size_t N>
+constexpr bool ucfPagesValid(const ucf_line_t (&lines)[N]) {
+    uint8_t bank = UCF_BANK_USER;
+    bool writeEnabled = false;
+    bool addressed = false;
+
+    for (size_t i = 0; i < N; i++) {
+        uint8_t reg = lines[i].address;
+        uint8_t value = lines[i].data;
+
+        if (reg == UCF_REG_FUNC_CFG_ACCESS) {
+            bank = value;
+            continue;
+        }
+        if (bank != UCF_BANK_EMBEDDED) {
+            continue;
+        }
+
+        if (reg == UCF_REG_PAGE_RW) {
+            writeEnabled = (value & UCF_PAGE_RW_WRITE) != 0;
+        } else if (reg == UCF_REG_PAGE_SEL) {
+            if ((value & 0x01) == 0) {
+                return false;
+            }
+        } else if (reg == UCF_REG_PAGE_ADDRESS) {
+            addressed = true;
+        } else if (reg == UCF_REG_PAGE_VALUE) {
+            if (!writeEnabled || !addressed) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <size_t N>
+constexpr bool ucfValid(const ucf_line_t (&lines)[N]) {
+    return ucfAddressesValid(lines) && ucfBanksValid(lines) && ucfPagesValid(lines);
+}
+
+// Length of the PAGE_VALUE run starting at line i (0 if line i is not PAGE_VALUE)
+template <size_t N>
+constexpr size_t ucfRunLength(const ucf_line_t (&lines)[N], size_t i) {
+    size_t n = 0;
+    while (i + n < N && n < UCF_PACKED_MAX_RUN && lines[i + n].address == UCF_REG_PAGE_VALUE) {
+        n++;
+    }
+    return n;
+}
+
+template <size_t N>
+constexpr size_t ucfPackedSize(const ucf_line_t (&lines)[N]) {
+    size_t size = 0;
+    size_t i = 0;
+    while (i < N) {
+        size_t run = ucfRunLength(lines, i);
+        if (run > 1) {
+            size += 2 + run;
+            i += run;
+        } else {
+            size += 2;
+            i++;
+        }
+    }
+    return size;
+}
+
+template <size_t Size>
+struct UcfPacked {
+    uint8_t bytes[Size];
+};
+
+template <size_t Size, size_t N>
+constexpr UcfPacked<Size> ucfPack(const ucf_line_t (&lines)[N]) {
+    UcfPacked<Size> out{};
+    size_t o = 0;
+    size_t i = 0;
+    while (i < N) {
+        size_t run = ucfRunLength(lines, i);
+        if (run > 1) {
+            out.bytes[o++] = UCF_PACKED_RUN | UCF_REG_PAGE_VALUE;
+            out.bytes[o++] = (uint8_t)run;
+            for (size_t k = 0; k < run; k++) {
+                out.bytes[o++] = lines[i + k].data;
+            }
+            i += run;
+        } else {
+            out.bytes[o++] = lines[i].address;
+            out.bytes[o++] = lines[i].data;
+            i++;
+        }
+    }
+    return out;
+}
+
+// Validates a UCF table and defines its packed copy; a broken table fails the build
+#define UCF_PACK_PROGRAM(name, table) \
+    static_assert(ucfAddressesValid(table), #table ": register address above 0x7F"); \
+    static_assert(ucfBanksValid(table), #table ": bad FUNC_CFG_ACCESS value or program does not end in the user bank"); \
+    static_assert(ucfPagesValid(table), #table ": page register misuse (bank, PAGE_SEL bit 0, or PAGE_VALUE before PAGE_RW/PAGE_ADDRESS)"); \
+    static constexpr UcfPacked<ucfPackedSize(table)> name = ucfPack<ucfPackedSize(table)>(table)
+
+#endif // UCF_PACKED_H
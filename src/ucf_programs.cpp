@@ -0,0 +1,11 @@
+#include "ucf_programs.h"
+#include "ucf_packed.h"
+#include "onoff.h"
+#include "movement.h"
+
+// Only the packed copies are referenced, so the ucf_line_t tables never reach flash
+UCF_PACK_PROGRAM(onoffPacked, onoff);
+UCF_PACK_PROGRAM(movementPacked, movement);
+
+const UcfProgram UCF_ONOFF = { "onoff", onoffPacked.bytes, sizeof(onoffPacked.bytes) };
+const UcfProgram UCF_MOVEMENT = { "movement", movementPacked.bytes, sizeof(movementPacked.bytes) };
@@ -0,0 +1,17 @@
+#ifndef UCF_PROGRAMS_H
+#define UCF_PROGRAMS_H
+
+#include <stdint.h>
+
+// A UCF program in the packed form of ucf_packed.h
+struct UcfProgram {
+    const char* name;
+    const uint8_t* data;
+    uint16_t size;
+};
+
+// MLC programs shipped with the firmware, validated and packed at build time
+extern const UcfProgram UCF_ONOFF;     // onoff.h: machine on/off
+extern const UcfProgram UCF_MOVEMENT;  // movement.h: movement classes
+
+#endif // UCF_PROGRAMS_H